@@ -0,0 +1,298 @@
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Emulators/FileLoader.hpp"
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/InstructionMix.hpp"
+#include "Emulators/HackEmulator/KeyboardInput.hpp"
+#include "Emulators/HackEmulator/NativeTranslator.hpp"
+#include "Emulators/HackEmulator/WideHackEmulator.hpp"
+
+// Measures HackEmulator throughput in instructions per second.
+// Run from the build directory (paths are relative, like the tests):
+//     ./HackEmulator_benchmark [cycles] [mix.json]
+// Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers. With a JSON
+// path, each workload also runs once with an InstructionMix attached and the
+// mixes are written there, keyed by workload.
+
+// Translated at build time by HackEmulator_aot (see HACK_NATIVE_PROGRAMS)
+uint64_t hack_native_Pong(int16_t*, int16_t&, int16_t&, uint16_t&, uint64_t);
+uint64_t hack_native_FibonacciElement(int16_t*, int16_t&, int16_t&, uint16_t&, uint64_t);
+uint64_t hack_native_StaticsTest(int16_t*, int16_t&, int16_t&, uint16_t&, uint64_t);
+
+struct Workload {
+    std::string name;
+    std::string path;
+    uint64_t cyclesPerRun;  // 0 runs the program once for the whole budget
+    NativeProgram native;
+};
+
+const std::string TEST_CASES = "../test/Emulators/HackEmulator/integration/TestCases/";
+
+// Programs that finish are restored to their starting snapshot and rerun until the cycle budget is spent.
+const std::vector<Workload> WORKLOADS = {
+    { "Pong",             "../test/HackAssembler/integration/expectedOutput/pong/Pong.hack", 0, hack_native_Pong },
+    { "FibonacciElement", TEST_CASES + "Project8/Function Calls/FibonacciElement/FibonacciElement.hack", 6000,
+      hack_native_FibonacciElement },
+    { "StaticsTest",      TEST_CASES + "Project8/Function Calls/StaticsTest/StaticsTest.hack", 2500, hack_native_StaticsTest },
+};
+
+RunResult runWorkload(HackEmulator& emu, const Workload& workload, uint64_t cycles, InstructionMix* mix = nullptr) {
+    auto run = [&](uint64_t budget) { return mix ? emu.run(budget, *mix) : emu.run(budget); };
+    if (workload.cyclesPerRun == 0) {
+        return run(cycles);
+    }
+
+    HackSnapshot start = emu.snapshot();
+    RunResult total = { 0, StopReason::CYCLE_LIMIT, 0 };
+    while (total.cycles < cycles) {
+        emu.restore(start);
+        RunResult result = run(std::min(workload.cyclesPerRun, cycles - total.cycles));
+        total.cycles += result.cycles;
+        total.pc = result.pc;
+    }
+    return total;
+}
+
+// Native code fast-forwards halt loops, so each run is capped at the cycles the
+// emulator needed to halt. Both rerun programs start with the bootstrap code,
+// which sets SP itself, so a rerun only resets the registers.
+RunResult runNative(const Workload& workload, uint64_t cycles, uint64_t cyclesPerRun) {
+    std::vector<int16_t> ram(32768, 0);
+    ram[HackEmulator::STACK_POINTER] = 256;
+    int16_t a = 0;
+    int16_t d = 0;
+    uint16_t pc = 0;
+    RunResult total = { 0, StopReason::CYCLE_LIMIT, 0 };
+    while (total.cycles < cycles) {
+        a = d = 0;
+        pc = 0;
+        total.cycles += workload.native(ram.data(), a, d, pc, std::min(cyclesPerRun, cycles - total.cycles));
+        total.pc = pc;
+        if (workload.cyclesPerRun == 0) {
+            break;
+        }
+    }
+    return total;
+}
+
+// --- Interactive Input ---
+// Pong with the bat steered by a scripted key sequence, switching between the
+// arrow keys every KEY_PERIOD cycles.
+
+const uint64_t KEY_PERIOD = 250000;
+
+RunResult runWithKeys(HackEmulator& emu, uint64_t cycles) {
+    KeyboardInput keys;
+    for (uint64_t cycle = KEY_PERIOD; cycle < cycles; cycle += KEY_PERIOD) {
+        keys.schedule(cycle, (cycle / KEY_PERIOD) % 2 ? 132 : 130);
+    }
+    emu.setKeyboardInput(&keys);
+    RunResult result = emu.run(cycles);
+    emu.setKeyboardInput(nullptr);
+    return result;
+}
+
+// --- Busy Waiting ---
+// Repeated calls to the compiled Sys.wait(WAIT_DURATION) inside Pong.hack, run
+// cycle by cycle or with loop acceleration.
+
+const uint16_t SYS_WAIT = 27194;
+const int16_t WAIT_DURATION = 500;
+
+RunResult runWaits(HackEmulator& emu, uint64_t cycles) {
+    RunResult total = { 0, StopReason::CYCLE_LIMIT, 0 };
+    while (total.cycles < cycles) {
+        emu.setRamValue(256, WAIT_DURATION);
+        emu.setRamValue(257, 0);             // Return address
+        emu.setRamValue(HackEmulator::STACK_POINTER, 262);
+        emu.setRamValue(HackEmulator::LCL_POINTER, 262);
+        emu.setRamValue(HackEmulator::ARG_POINTER, 256);
+        emu.setPC(SYS_WAIT);
+        RunResult result = emu.runUntil(0, cycles - total.cycles);
+        total.cycles += result.cycles;
+        total.pc = result.pc;
+    }
+    return total;
+}
+
+// --- Parameter Sweep ---
+// FibonacciSeries with a different series length per machine, SWEEP_LANES
+// machines per round, run one after another or as lanes of WideHackEmulator.
+
+const size_t SWEEP_LANES = 16;
+const uint64_t SWEEP_CYCLES = 4000;   // Per machine and round
+const std::string SWEEP_PATH = TEST_CASES + "Project8/Program Flow/FibonacciSeries/FibonacciSeries.hack";
+
+template <typename SetRam>
+void setupSweep(SetRam setRam, size_t lane) {
+    setRam(HackEmulator::STACK_POINTER, 256);
+    setRam(HackEmulator::LCL_POINTER, 300);
+    setRam(HackEmulator::ARG_POINTER, 400);
+    setRam(400, static_cast<int16_t>(5 + lane));
+    setRam(401, 3000);
+}
+
+RunResult runSweepSequential(const std::vector<int16_t>& program, uint64_t cycles) {
+    std::vector<HackEmulator> machines(SWEEP_LANES);
+    std::vector<HackSnapshot> starts;
+    for (size_t lane = 0; lane < SWEEP_LANES; lane++) {
+        machines[lane].setMemoryMode(MemoryMode::FAST);
+        machines[lane].setHaltDetection(false);
+        machines[lane].loadProgram(program);
+        setupSweep([&](uint16_t addr, int16_t value) { machines[lane].setRamValue(addr, value); }, lane);
+        starts.push_back(machines[lane].snapshot());
+    }
+
+    RunResult total = { 0, StopReason::CYCLE_LIMIT, 0 };
+    while (total.cycles < cycles) {
+        for (size_t lane = 0; lane < SWEEP_LANES; lane++) {
+            machines[lane].restore(starts[lane]);
+            total.cycles += machines[lane].run(SWEEP_CYCLES).cycles;
+        }
+    }
+    return total;
+}
+
+RunResult runSweepWide(const std::vector<int16_t>& program, uint64_t cycles) {
+    WideHackEmulator<SWEEP_LANES> wide;
+    wide.loadProgram(program);
+
+    RunResult total = { 0, StopReason::CYCLE_LIMIT, 0 };
+    while (total.cycles < cycles) {
+        wide.reset();
+        for (size_t lane = 0; lane < SWEEP_LANES; lane++) {
+            setupSweep([&](uint16_t addr, int16_t value) { wide.setRamValue(lane, addr, value); }, lane);
+        }
+        for (const RunResult& result : wide.run(SWEEP_CYCLES)) {
+            total.cycles += result.cycles;
+        }
+    }
+    return total;
+}
+
+void printRow(const std::string& workload, const std::string& mode, const std::string& memory,
+              const RunResult& result, double seconds) {
+    double mips = result.cycles / seconds / 1e6;
+    std::cout << std::left << std::setw(20) << workload
+              << std::setw(14) << mode
+              << std::setw(10) << memory
+              << std::right << std::setw(14) << result.cycles
+              << std::setw(12) << std::fixed << std::setprecision(3) << seconds
+              << std::setw(12) << std::setprecision(1) << mips << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t cycles = argc > 1 ? std::stoull(argv[1]) : 50000000;
+    std::string mixPath = argc > 2 ? argv[2] : "";
+    std::ostringstream mixJson;
+    FileLoader loader;
+
+    std::cout << std::left << std::setw(20) << "Workload"
+              << std::setw(14) << "Mode"
+              << std::setw(10) << "Memory"
+              << std::right << std::setw(14) << "Cycles"
+              << std::setw(12) << "Seconds"
+              << std::setw(12) << "MIPS" << std::endl;
+
+    for (const Workload& workload : WORKLOADS) {
+        std::vector<int16_t> program = loader.loadFile(workload.path);
+
+        for (ExecutionMode mode : { ExecutionMode::INTERPRETED, ExecutionMode::BLOCK_CACHE }) {
+            for (MemoryMode memory : { MemoryMode::STRICT, MemoryMode::FAST }) {
+                HackEmulator emu;
+                emu.setExecutionMode(mode);
+                emu.setMemoryMode(memory);
+                emu.loadProgram(program);
+                emu.setRamValue(HackEmulator::STACK_POINTER, 256);
+
+                auto start = std::chrono::steady_clock::now();
+                RunResult result = runWorkload(emu, workload, cycles);
+                auto end = std::chrono::steady_clock::now();
+
+                printRow(workload.name, mode == ExecutionMode::INTERPRETED ? "interpreted" : "block-cache",
+                         memory == MemoryMode::STRICT ? "strict" : "fast", result,
+                         std::chrono::duration<double>(end - start).count());
+            }
+        }
+
+        HackEmulator reference;
+        reference.loadProgram(program);
+        reference.setRamValue(HackEmulator::STACK_POINTER, 256);
+        uint64_t cyclesPerRun = reference.run(workload.cyclesPerRun == 0 ? cycles : workload.cyclesPerRun).cycles;
+
+        // Native code is translated with FAST memory semantics
+        auto start = std::chrono::steady_clock::now();
+        RunResult result = runNative(workload, cycles, cyclesPerRun);
+        auto end = std::chrono::steady_clock::now();
+        printRow(workload.name, "native", "fast", result, std::chrono::duration<double>(end - start).count());
+
+        if (!mixPath.empty()) {
+            HackEmulator emu;
+            emu.setMemoryMode(MemoryMode::FAST);
+            emu.loadProgram(program);
+            emu.setRamValue(HackEmulator::STACK_POINTER, 256);
+
+            InstructionMix mix;
+            start = std::chrono::steady_clock::now();
+            result = runWorkload(emu, workload, cycles, &mix);
+            end = std::chrono::steady_clock::now();
+            printRow(workload.name, "mix", "fast", result, std::chrono::duration<double>(end - start).count());
+
+            mixJson << (mixJson.tellp() == 0 ? "{\n" : ",\n") << "\"" << workload.name << "\": ";
+            InstructionMix::writeJson(mixJson, mix.summarize(emu));
+        }
+    }
+    if (!mixPath.empty()) {
+        std::ofstream out(mixPath);
+        out << mixJson.str() << "\n}\n";
+        if (!out) {
+            std::cerr << "Could not write " << mixPath << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<int16_t> pong = loader.loadFile(WORKLOADS[0].path);
+    for (ExecutionMode mode : { ExecutionMode::INTERPRETED, ExecutionMode::BLOCK_CACHE }) {
+        HackEmulator emu;
+        emu.setExecutionMode(mode);
+        emu.setMemoryMode(MemoryMode::FAST);
+        emu.loadProgram(pong);
+
+        auto start = std::chrono::steady_clock::now();
+        RunResult result = runWithKeys(emu, cycles);
+        auto end = std::chrono::steady_clock::now();
+        printRow("Pong + keys", mode == ExecutionMode::INTERPRETED ? "interpreted" : "block-cache", "fast", result,
+                 std::chrono::duration<double>(end - start).count());
+    }
+
+    for (bool accelerate : { false, true }) {
+        HackEmulator emu;
+        emu.setMemoryMode(MemoryMode::FAST);
+        emu.setLoopAcceleration(accelerate);
+        emu.loadProgram(pong);
+
+        auto start = std::chrono::steady_clock::now();
+        RunResult result = runWaits(emu, cycles);
+        auto end = std::chrono::steady_clock::now();
+        printRow("Sys.wait(" + std::to_string(WAIT_DURATION) + ")", accelerate ? "accelerated" : "interpreted", "fast",
+                 result, std::chrono::duration<double>(end - start).count());
+    }
+
+    std::vector<int16_t> sweep = loader.loadFile(SWEEP_PATH);
+    const std::string sweepName = "Sweep x" + std::to_string(SWEEP_LANES);
+    for (bool wide : { false, true }) {
+        auto start = std::chrono::steady_clock::now();
+        RunResult result = wide ? runSweepWide(sweep, cycles) : runSweepSequential(sweep, cycles);
+        auto end = std::chrono::steady_clock::now();
+        printRow(sweepName, wide ? "wide" : "interpreted", "fast", result,
+                 std::chrono::duration<double>(end - start).count());
+    }
+    return 0;
+}
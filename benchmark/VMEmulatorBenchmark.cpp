@@ -0,0 +1,168 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Emulators/VMEmulator/VMEmulator.hpp"
+
+// Measures VMEmulator throughput in VM commands per second for each way of
+// dispatching them. Every workload loops forever, so any step budget works:
+//     ./VMEmulator_benchmark [steps]
+// Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers. The step rows
+// call executeNextInstruction() once per command. They measure the current
+// core one call at a time, not the old std::function dispatch, which is gone.
+
+struct Workload {
+    std::string name;
+    std::vector<std::string> program;
+};
+
+const std::vector<Workload> WORKLOADS = {
+    // Counts local 0 down from 1000, summing into local 1
+    { "Countdown", {
+        "label START",
+        "push constant 1000", "pop local 0",
+        "label LOOP",
+        "push local 0", "push constant 1", "sub", "pop local 0",
+        "push local 1", "push local 0", "add", "pop local 1",
+        "push local 0", "push constant 0", "gt", "if-goto LOOP",
+        "goto START"
+    } },
+    // Comparisons and bitwise logic on temp and static values
+    { "Logic", {
+        "label LOOP",
+        "push temp 0", "push constant 1", "add", "pop temp 0",
+        "push temp 0", "push constant 7", "and", "push constant 3", "eq",
+        "push temp 0", "push static 0", "lt", "or", "not", "pop static 1",
+        "push temp 0", "neg", "push static 1", "gt", "pop static 0",
+        "goto LOOP"
+    } },
+    // Recursive fibonacci(12), as in FibonacciElement
+    { "Recursion", {
+        "label START",
+        "push constant 12", "call Main.fibonacci 1", "pop temp 0",
+        "goto START",
+        "function Main.fibonacci 0",
+        "push argument 0", "push constant 2", "lt", "if-goto BASE",
+        "push argument 0", "push constant 2", "sub", "call Main.fibonacci 1",
+        "push argument 0", "push constant 1", "sub", "call Main.fibonacci 1",
+        "add", "return",
+        "label BASE",
+        "push argument 0", "return"
+    } },
+    // Fills RAM[3000..3099] through pointer 1 and that 0, as in FibonacciSeries
+    { "Arrays", {
+        "label START",
+        "push constant 0", "pop local 0",
+        "label LOOP",
+        "push constant 3000", "push local 0", "add", "pop pointer 1",
+        "push local 0", "push local 0", "add", "pop that 0",
+        "push local 0", "push constant 1", "add", "pop local 0",
+        "push local 0", "push constant 100", "lt", "if-goto LOOP",
+        "goto START"
+    } },
+    // CompilationEngine output for copying one 100-element array into another
+    // and summing it, run forever; the sequences superinstructions replace
+    { "JackArrays", {
+        "function Main.main 4",
+        "push constant 3000", "pop local 0", "push constant 4000", "pop local 1",
+        "label Main.WHILE_EXP0",
+        "push constant 0", "not", "not", "if-goto Main.WHILE_END1",
+        "push constant 0", "pop local 2",
+        "label Main.WHILE_EXP2",
+        "push local 2", "push constant 100", "lt", "not", "if-goto Main.WHILE_END3",
+        "push local 0", "push local 2", "add", "push local 2", "push local 3", "add",
+        "pop temp 0", "pop pointer 1", "push temp 0", "pop that 0",
+        "push local 2", "push constant 1", "add", "pop local 2",
+        "goto Main.WHILE_EXP2",
+        "label Main.WHILE_END3",
+        "push constant 0", "pop local 2",
+        "label Main.WHILE_EXP4",
+        "push local 2", "push constant 100", "lt", "not", "if-goto Main.WHILE_END5",
+        "push local 1", "push local 2", "add",
+        "push local 0", "push local 2", "add", "pop pointer 1", "push that 0",
+        "pop temp 0", "pop pointer 1", "push temp 0", "pop that 0",
+        "push local 3", "push local 1", "push local 2", "add", "pop pointer 1", "push that 0", "add",
+        "pop local 3",
+        "push local 2", "push constant 1", "add", "pop local 2",
+        "goto Main.WHILE_EXP4",
+        "label Main.WHILE_END5",
+        "push local 3", "call Main.touch 1", "pop temp 0",
+        "goto Main.WHILE_EXP0",
+        "label Main.WHILE_END1",
+        "push constant 0", "return",
+        "function Main.touch 0",
+        "push argument 0", "push constant 1", "add", "pop argument 0",
+        "push constant 0", "return"
+    } },
+};
+
+void setup(VMEmulator& vm, const Workload& workload) {
+    vm.loadRawProgram(workload.program);
+    vm.poke(VMEmulator::STACK_POINTER, 256);
+    vm.poke(VMEmulator::LCL_POINTER, 300);
+    vm.poke(VMEmulator::ARG_POINTER, 400);
+}
+
+void printRow(const std::string& workload, const std::string& mode, uint64_t steps, double seconds) {
+    std::cout << std::left << std::setw(14) << workload
+              << std::setw(12) << mode
+              << std::right << std::setw(14) << steps
+              << std::setw(12) << std::fixed << std::setprecision(3) << seconds
+              << std::setw(14) << std::setprecision(1) << steps / seconds / 1e6 << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t steps = argc > 1 ? std::stoull(argv[1]) : 50000000;
+
+    std::cout << std::left << std::setw(14) << "Workload"
+              << std::setw(12) << "Dispatch"
+              << std::right << std::setw(14) << "Steps"
+              << std::setw(12) << "Seconds"
+              << std::setw(14) << "Mops/s" << std::endl;
+
+    for (const Workload& workload : WORKLOADS) {
+        VMEmulator vm;
+        setup(vm, workload);
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < steps; i++) {
+            vm.executeNextInstruction();
+        }
+        auto end = std::chrono::steady_clock::now();
+        printRow(workload.name, "step", steps, std::chrono::duration<double>(end - start).count());
+
+        for (VMDispatch dispatch : { VMDispatch::SWITCH, VMDispatch::THREADED }) {
+            if (dispatch == VMDispatch::THREADED && !VMEmulator::THREADED_DISPATCH_SUPPORTED) {
+                continue;
+            }
+            setup(vm, workload);
+            vm.setDispatch(dispatch);
+            start = std::chrono::steady_clock::now();
+            uint64_t executed = vm.executeInstructions(steps);
+            end = std::chrono::steady_clock::now();
+            printRow(workload.name, dispatch == VMDispatch::SWITCH ? "switch" : "threaded", executed,
+                     std::chrono::duration<double>(end - start).count());
+        }
+
+        // Fastest core plus superinstructions, a cached stack, or both
+        struct Variant {
+            const char* name;
+            bool fused;
+            bool cached;
+        };
+        for (Variant variant : { Variant{ "fused", true, false }, Variant{ "cached", false, true },
+                                 Variant{ "fused+cached", true, true } }) {
+            setup(vm, workload);
+            vm.setDispatch(VMEmulator::THREADED_DISPATCH_SUPPORTED ? VMDispatch::THREADED : VMDispatch::SWITCH);
+            vm.setSuperinstructions(variant.fused);
+            vm.setStackCaching(variant.cached);
+            start = std::chrono::steady_clock::now();
+            uint64_t executed = vm.executeInstructions(steps);
+            end = std::chrono::steady_clock::now();
+            printRow(workload.name, variant.name, executed, std::chrono::duration<double>(end - start).count());
+        }
+    }
+    return 0;
+}
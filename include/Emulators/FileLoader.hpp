@@ -18,6 +18,8 @@ private:
 public:
     std::vector<int16_t> loadFile(const std::string& filepath);
     static std::vector<std::string> loadRawLines(const std::string& filepath);
+    // The whole file in one read
+    static std::string loadText(const std::string& filepath);
 };
 
 #endif
\ No newline at end of file
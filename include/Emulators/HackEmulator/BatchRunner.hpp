@@ -0,0 +1,67 @@
+#ifndef BATCH_RUNNER_HPP
+#define BATCH_RUNNER_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+
+struct RamCheck {
+    uint16_t address;
+    int16_t expected;
+};
+
+// One stretch of a job: set RAM, run, then compare RAM
+struct BatchStep {
+    std::vector<std::pair<uint16_t, int16_t>> setRam;
+    uint64_t cycles = 0;
+    std::vector<RamCheck> checks;
+};
+
+// One program run: load, then each step in order on the same machine
+struct BatchJob {
+    std::string name;
+    std::string programPath;                            // .hack or .bin, loaded with FileLoader
+    std::vector<BatchStep> steps;
+};
+
+struct BatchResult {
+    std::string name;
+    bool passed = false;
+    RunResult run = { 0, StopReason::CYCLE_LIMIT, 0 };
+    std::vector<std::string> failures;                  // Failed checks, or the exception that stopped the run
+    double seconds = 0;
+};
+
+// Runs jobs on a pool of worker threads, each with its own HackEmulator.
+// Jobs are dealt round-robin into per-worker deques; a worker takes from the
+// back of its own deque and steals from the front of the others when empty.
+class BatchRunner {
+public:
+    explicit BatchRunner(size_t threads, ExecutionMode mode = ExecutionMode::INTERPRETED);
+
+    // Results are returned in job order
+    std::vector<BatchResult> run(const std::vector<BatchJob>& jobs) const;
+
+    // Reads a nand2tetris CPU emulator test script (.tst) and its .cmp file.
+    // Commands run in script order: "set RAM[n] v" sets RAM, "ticktock" runs
+    // a cycle, "repeat N { ... }" runs its block N times, and each "output"
+    // checks the output-list columns against the next row of the .cmp file,
+    // whose header must name the same columns. "load X.asm" runs X.hack from
+    // the same directory, or the only .hack file there if X.hack does not
+    // exist. output-file and compare-to are accepted and ignored; any other
+    // command throws.
+    static BatchJob loadTestScript(const std::string& tstPath);
+
+    // Every .tst script under dir, sorted by path
+    static std::vector<BatchJob> discoverTestScripts(const std::string& dir);
+
+private:
+    size_t threads;
+    ExecutionMode mode;
+
+    static BatchResult runJob(const BatchJob& job, HackEmulator& emu, const std::vector<int16_t>& program);
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef C_INSTRUCTION_TABLE_HPP
+#define C_INSTRUCTION_TABLE_HPP
+
+#include <array>
+#include <string>
+#include <utility>
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/HackAlu.hpp"
+
+// Private to the HackEmulator sources.
+
+// --- Memory Policies ---
+// StrictMemory throws on addresses past the keyboard register, as peek() and
+// setRamValue() do. FastMemory masks into the 32K RAM array and never throws.
+
+struct HackEmulator::StrictMemory {
+    static constexpr bool checked = true;
+    static uint16_t index(uint16_t addr) { return addr; }
+
+    static int16_t read(const HackEmulator& emu, uint16_t addr) {
+        emu.checkRamAddress(addr);
+        return emu.ram[addr];
+    }
+
+    static void write(HackEmulator& emu, uint16_t addr, int16_t value) {
+        emu.checkRamAddress(addr);
+        emu.storeRam(addr, value);
+    }
+};
+
+struct HackEmulator::FastMemory {
+    static constexpr bool checked = false;
+    static uint16_t index(uint16_t addr) { return addr & (RAM_SPACE - 1); }
+
+    static int16_t read(const HackEmulator& emu, uint16_t addr) { return emu.ram[index(addr)]; }
+    static void write(HackEmulator& emu, uint16_t addr, int16_t value) { emu.storeRam(index(addr), value); }
+};
+
+// --- C-instruction Handlers ---
+//
+// Every 13-bit C payload (a comp dest jump) gets its own handler, instantiated
+// from the template below with the comp, dest and jump fields as constants, so
+// a handler never branches on instruction fields at runtime. Payloads with an
+// unknown comp all share the trap handler. There is one table per memory policy.
+
+struct HackEmulator::CInstructionTable {
+    using Handler = void (*)(HackEmulator&);
+
+    static constexpr bool isValidComp(uint16_t comp) {
+        switch (comp & 0x3F) {
+            case 0b101010: case 0b111111: case 0b111010: case 0b001100:
+            case 0b110000: case 0b001101: case 0b110001: case 0b001111:
+            case 0b110011: case 0b011111: case 0b110111: case 0b001110:
+            case 0b110010: case 0b000010: case 0b010011: case 0b000111:
+            case 0b000000: case 0b010101:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Comp includes the a-bit as bit 6
+    template <uint16_t Comp, typename Memory>
+    static inline int16_t compute(HackEmulator& emu) {
+        constexpr uint16_t c = Comp & 0x3F;
+        constexpr bool useM = (Comp >> 6) & 0x1;
+
+        if constexpr (aluReadsY(c)) {
+            int16_t y = useM ? Memory::read(emu, emu.a_register) : emu.a_register;
+            return aluCompute(c, emu.d_register, y);
+        } else {
+            return aluCompute(c, emu.d_register, 0);
+        }
+    }
+
+    template <uint16_t Payload, typename Memory>
+    static void execute(HackEmulator& emu) {
+        constexpr uint16_t comp = (Payload >> 6) & 0x7F;
+        constexpr uint8_t control = Payload & 0x3F;
+        constexpr uint8_t jump = control & (JUMP_GT | JUMP_EQ | JUMP_LT);
+
+        int16_t result = compute<comp, Memory>(emu);
+        uint16_t write_addr = emu.a_register;
+
+        if constexpr ((control & DEST_D) != 0) { emu.d_register = result; }
+        if constexpr ((control & DEST_A) != 0) { emu.a_register = result; }
+        if constexpr ((control & DEST_M) != 0) { Memory::write(emu, write_addr, result); }
+
+        if constexpr (jump == 0) {
+            emu.program_counter++;
+        } else if constexpr (jump == (JUMP_GT | JUMP_EQ | JUMP_LT)) {
+            emu.program_counter = emu.a_register;
+        } else {
+            bool taken = ((jump & JUMP_GT) && result > 0) ||
+                         ((jump & JUMP_EQ) && result == 0) ||
+                         ((jump & JUMP_LT) && result < 0);
+            emu.program_counter = taken ? emu.a_register : emu.program_counter + 1;
+        }
+    }
+
+    static void trap(HackEmulator& emu) {
+        int16_t payload = emu.predecoded_rom[emu.program_counter].value;
+        throw std::runtime_error("Invalid ALU comp code: " + std::to_string((payload >> 6) & 0x3F));
+    }
+
+    template <uint16_t Payload, typename Memory>
+    static constexpr Handler select() {
+        if constexpr (isValidComp(Payload >> 6)) { return &execute<Payload, Memory>; }
+        else { return &trap; }
+    }
+
+    template <typename Memory, uint16_t... Payloads>
+    static constexpr std::array<Handler, sizeof...(Payloads)> build(std::integer_sequence<uint16_t, Payloads...>) {
+        return { select<Payloads, Memory>()... };
+    }
+
+    static const std::array<Handler, 8192> strictHandlers;
+    static const std::array<Handler, 8192> fastHandlers;
+};
+
+#endif
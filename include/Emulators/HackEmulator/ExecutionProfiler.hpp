@@ -0,0 +1,66 @@
+#ifndef EXECUTION_PROFILER_HPP
+#define EXECUTION_PROFILER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+
+// Counts executions per ROM address and RAM reads/writes per address while a
+// HackEmulator runs with it: emu.run(cycles, profiler). Runs without a
+// profiler are compiled without the hooks, so they cost nothing when unused.
+class ExecutionProfiler {
+public:
+    static constexpr bool enabled = true;
+
+    ExecutionProfiler();
+    void reset();
+
+    // Called by the emulator before each instruction executes
+    void onInstruction(uint16_t pc, const MicroOp& op, int16_t a) {
+        executions[pc & (ROM_SPACE - 1)]++;
+        if (op.alu == AluOp::LOAD_A) {
+            return;
+        }
+        uint16_t addr = static_cast<uint16_t>(a) & (RAM_SPACE - 1);
+        if (aluReadsM(op.alu)) {
+            reads[addr]++;
+        }
+        if (op.control & HackEmulator::DEST_M) {
+            writes[addr]++;
+        }
+    }
+
+    void afterInstruction(uint16_t, const MicroOp&, int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+
+    uint64_t getExecutions(uint16_t romAddress) const { return executions[romAddress & (ROM_SPACE - 1)]; }
+    uint64_t getReads(uint16_t ramAddress) const { return reads[ramAddress & (RAM_SPACE - 1)]; }
+    uint64_t getWrites(uint16_t ramAddress) const { return writes[ramAddress & (RAM_SPACE - 1)]; }
+    uint64_t getTotalExecutions() const;
+
+    // Joins the counts with a listing written by HackAssembler (<name>.listing.txt)
+    // and prints the hottest instructions, labels, source comments and RAM words.
+    // For VM-translated code the source comments are the VM commands.
+    void writeReport(std::ostream& out, const std::string& listingPath, size_t top = 20) const;
+
+    // One assembled instruction from the listing
+    struct ListingLine {
+        std::string source;
+        std::string label;     // Nearest label at or above the instruction
+        std::string comment;   // Nearest comment line above the instruction, within the label
+    };
+
+    // Indexed by ROM address; addresses the listing does not cover are empty
+    static std::vector<ListingLine> loadListing(const std::string& listingPath);
+
+private:
+    const static uint32_t ROM_SPACE = 32768;
+    const static uint32_t RAM_SPACE = 32768;
+
+    std::vector<uint64_t> executions;
+    std::vector<uint64_t> reads;
+    std::vector<uint64_t> writes;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef EXECUTION_TRACER_HPP
+#define EXECUTION_TRACER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/TraceRingBuffer.hpp"
+
+// State after one executed instruction
+struct TraceRecord {
+    uint16_t pc;           // ROM address of the instruction
+    int16_t a_register;
+    int16_t d_register;
+    uint16_t flags;        // ExecutionTracer::WROTE_M
+    uint16_t m_address;    // Written RAM address and value, 0 unless WROTE_M
+    int16_t m_value;
+};
+
+enum class TraceOverflow {
+    OVERWRITE,         // Keep the newest records; read them with drain() after the run
+    WAIT               // Block the emulator until a TraceWriter makes room
+};
+
+// Records every instruction executed by emu.run(cycles, tracer) into a ring
+// buffer. Runs without a tracer are compiled without the hooks.
+class ExecutionTracer {
+public:
+    static constexpr bool enabled = true;
+    static constexpr uint16_t WROTE_M = 1;
+
+    explicit ExecutionTracer(size_t capacity = 65536, TraceOverflow overflow = TraceOverflow::OVERWRITE)
+        : ring(capacity), overflow(overflow) {}
+
+    void onInstruction(uint16_t, const MicroOp&, int16_t) {}
+
+    // Called by the emulator after each instruction; addressA is the A register
+    // the instruction ran with and m the RAM word it addresses afterwards.
+    void afterInstruction(uint16_t pc, const MicroOp& op, int16_t addressA, int16_t a, int16_t d, int16_t m, uint16_t) {
+        TraceRecord record = { pc, a, d, 0, 0, 0 };
+        if (op.alu != AluOp::LOAD_A && (op.control & HackEmulator::DEST_M)) {
+            record.flags = WROTE_M;
+            record.m_address = static_cast<uint16_t>(addressA);
+            record.m_value = m;
+        }
+        if (overflow == TraceOverflow::OVERWRITE) {
+            ring.pushOverwrite(record);
+            return;
+        }
+        while (!ring.tryPush(record)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Consumer side: moves up to maxRecords of the oldest records into out
+    size_t drain(TraceRecord* out, size_t maxRecords) { return ring.popBatch(out, maxRecords); }
+    std::vector<TraceRecord> drain();
+
+    TraceOverflow getOverflow() const { return overflow; }
+    size_t capacity() const { return ring.capacity(); }
+
+private:
+    TraceRingBuffer<TraceRecord> ring;
+    TraceOverflow overflow;
+};
+
+// Drains a WAIT-mode tracer on its own thread into a binary trace file: the
+// header "HTRC", version and record size (uint16 each), then one 12-byte
+// little-endian record per instruction in TraceRecord field order.
+class TraceWriter {
+public:
+    TraceWriter(ExecutionTracer& tracer, const std::string& path);
+    ~TraceWriter();
+
+    // Drains the remaining records and joins the thread. Rethrows a write error.
+    void finish();
+    uint64_t getRecordCount() const { return records_written.load(std::memory_order_relaxed); }
+
+    static std::vector<TraceRecord> readTrace(const std::string& path);
+
+    const static uint16_t VERSION = 1;
+    const static uint16_t RECORD_SIZE = 12;
+
+private:
+    ExecutionTracer& tracer;
+    std::ofstream out;
+    std::thread consumer;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> records_written{0};
+    std::exception_ptr error;
+
+    void consume();
+    void writeBatch(const TraceRecord* records, size_t count, std::vector<char>& bytes);
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef HACK_ALU_HPP
+#define HACK_ALU_HPP
+
+#include <cstdint>
+
+// Private to the HackEmulator sources.
+//
+// The Hack ALU on the six c-bits of a comp field. The y operand is A or M,
+// picked by the a-bit, which the callers resolve before calling. Both are
+// constexpr so the compiled C-instruction handlers fold them to one expression.
+
+constexpr bool aluReadsY(uint16_t comp) {
+    switch (comp & 0x3F) {
+        case 0b110000: case 0b110001: case 0b110011: case 0b110111:
+        case 0b110010: case 0b000010: case 0b010011: case 0b000111:
+        case 0b000000: case 0b010101:
+            return true;
+        default:
+            return false;
+    }
+}
+
+constexpr int16_t aluCompute(uint16_t comp, int16_t d, int16_t y) {
+    switch (comp & 0x3F) {
+        case 0b101010: return 0;
+        case 0b111111: return 1;
+        case 0b111010: return -1;
+        case 0b001100: return d;
+        case 0b001101: return ~d;
+        case 0b001111: return -d;
+        case 0b011111: return d + 1;
+        case 0b001110: return d - 1;
+        case 0b110000: return y;
+        case 0b110001: return ~y;
+        case 0b110011: return -y;
+        case 0b110111: return y + 1;
+        case 0b110010: return y - 1;
+        case 0b000010: return d + y;
+        case 0b010011: return d - y;
+        case 0b000111: return y - d;
+        case 0b000000: return d & y;
+        case 0b010101: return d | y;
+        default:       return 0;
+    }
+}
+
+#endif
@@ -2,9 +2,12 @@
 #define HACK_EMULATOR_HPP
 
 #include <vector>
+#include <array>
 #include <cstdint>
 #include <stdexcept>
 #include <algorithm>
+#include <functional>
+#include <utility>
 
 
 enum class InstructionType {
@@ -29,27 +32,259 @@ struct DecodedInstruction {
     bool jump_JLT;     // xxxxxxxxxxxxx100
 };
 
+// Dense ALU operation chosen once at load time. Comps that read the A input
+// get a separate *_M variant so execution never re-checks the a-bit.
+enum class AluOp : uint8_t {
+    LOAD_A,            // A-instruction, A = value
+    ZERO, ONE, NEG_ONE,
+    D, A, M,
+    NOT_D, NOT_A, NOT_M,
+    NEG_D, NEG_A, NEG_M,
+    D_PLUS_ONE, A_PLUS_ONE, M_PLUS_ONE,
+    D_MINUS_ONE, A_MINUS_ONE, M_MINUS_ONE,
+    D_PLUS_A, D_PLUS_M,
+    D_MINUS_A, D_MINUS_M,
+    A_MINUS_D, M_MINUS_D,
+    D_AND_A, D_AND_M,
+    D_OR_A, D_OR_M,
+    INVALID            // Unknown comp code, traps when executed
+};
+
+// True for operations whose A input is RAM[A]
+inline bool aluReadsM(AluOp op) {
+    switch (op) {
+        case AluOp::M: case AluOp::NOT_M: case AluOp::NEG_M:
+        case AluOp::M_PLUS_ONE: case AluOp::M_MINUS_ONE:
+        case AluOp::D_PLUS_M: case AluOp::D_MINUS_M: case AluOp::M_MINUS_D:
+        case AluOp::D_AND_M: case AluOp::D_OR_M:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// One ROM word decoded at load time, packed into 32 bits.
+struct MicroOp {
+    int16_t value;     // A-instruction constant, or the 13-bit C payload (a comp dest jump)
+    AluOp alu;
+    uint8_t control;   // Low 6 instruction bits: dest (A D M) in 5..3, jump (LT EQ GT) in 2..0
+};
+
+static_assert(sizeof(MicroOp) == 4, "MicroOp must stay packed into 32 bits");
+
+enum class MemoryMode {
+    STRICT,            // Addresses past the keyboard register throw std::out_of_range
+    FAST               // Addresses are masked into a 32K RAM array, never checked
+};
+
+enum class ExecutionMode {
+    INTERPRETED,       // One predecoded instruction at a time
+    BLOCK_CACHE        // Translated basic blocks with fused stack idioms
+};
+
+enum class StopReason {
+    CYCLE_LIMIT,       // maxCycles instructions were executed
+    BREAKPOINT,        // PC reached the runUntil() target
+    PREDICATE,         // The runUntil() predicate returned true
+    HALTED             // The program is stuck in a loop that can never change state
+};
+
+struct RunResult {
+    uint64_t cycles;   // Instructions executed by this call
+    StopReason reason;
+    uint16_t pc;       // PC of the next instruction to execute
+};
+
+
+// Machine state captured by HackEmulator::snapshot(). ROM is not included, so
+// restore it into an emulator running the same program.
+struct HackSnapshot {
+    uint64_t id = 0;                  // Unique per snapshot() call
+    int16_t a_register = 0;
+    int16_t d_register = 0;
+    uint16_t program_counter = 0;
+    uint64_t cycle_count = 0;
+    std::vector<int16_t> ram;
+};
+
+class ExecutionProfiler;
+class ExecutionTracer;
+class KeyboardInput;
+class InstructionMix;
 
 class HackEmulator {
 private:
     // Total size of RAM including I/O (16K Data + 8K Screen + 1 Key)
     const static uint16_t MEMORY_SIZE      = 24577; 
+    // Backing store rounded up to a power of two so FAST mode can mask addresses
+    const static uint16_t RAM_SPACE        = 32768;
     
     // --- CPU Core Registers (16-bit) ---
     int16_t a_register = 0; 
     int16_t d_register = 0; 
     uint16_t program_counter = 0; 
+    uint64_t cycle_count = 0;
+
+    // The PC register is 16 bits wide but ROM only decodes 15 address bits, so
+    // per-PC tables cover all 65536 PC values with the upper half mirroring ROM.
+    const static size_t PC_SPACE = 65536;
 
     // --- Memory Units ---
-    std::vector<int16_t> rom;  // Instruction Memory
-    std::vector<int16_t> ram;  // Data Memory (including pointers and I/O)
+    std::vector<int16_t> rom;            // Instruction Memory
+    std::vector<MicroOp> predecoded_rom; // ROM decoded once by loadProgram(), PC_SPACE entries
+    std::vector<int16_t> ram;            // Data Memory (including pointers and I/O), RAM_SPACE entries
 
     // --- Private Helper to Check RAM Bounds ---
-    void checkRamAddress(uint16_t addr) const;
+    void checkRamAddress(uint16_t addr) const {
+        if (addr >= MEMORY_SIZE) {
+            throwIllegalAccess(addr);
+        }
+    }
+    [[noreturn]] void throwIllegalAccess(uint16_t addr) const;
+
+    // --- Dirty Page Tracking ---
+    // RAM is split into 256-word pages. Every write marks its page so restore()
+    // only copies pages changed since the snapshot it last synced with.
+    const static uint16_t PAGE_BITS  = 8;
+    const static uint16_t PAGE_COUNT = RAM_SPACE >> PAGE_BITS;
+
+    std::array<uint8_t, PAGE_COUNT> dirty_pages = {};
+    uint64_t synced_snapshot = 0;        // Id of the snapshot RAM matches outside dirty pages, 0 for none
+
+    // Writes are also marked per 32-word row, which is one screen row inside
+    // the screen map. Marking every row avoids a range check on each write.
+    const static uint16_t ROW_BITS = 5;
+    std::array<uint8_t, (RAM_SPACE >> ROW_BITS)> written_rows = {};
+
+    void storeRam(uint16_t index, int16_t value) {
+        ram[index] = value;
+        dirty_pages[index >> PAGE_BITS] = 1;
+        written_rows[index >> ROW_BITS] = 1;
+    }
+
+    // Compile-time table of C-instruction handlers, one per 13-bit payload
+    struct CInstructionTable;
+    struct StrictMemory;
+    struct FastMemory;
+    using CHandler = void (*)(HackEmulator&);
+
+    MemoryMode memory_mode = MemoryMode::STRICT;
+    const CHandler* c_handlers;          // Handler table for memory_mode
+
+    static MicroOp predecode(int16_t instruction);
+    void execute(MicroOp op);
+    void step();
+
+    // --- Block Cache (ExecutionMode::BLOCK_CACHE) ---
+    struct FusedOp;
+    struct BlockOps;
+    using FusedHandler = void (*)(HackEmulator&, const FusedOp&);
+
+    // One or more Hack instructions executed by a single handler call
+    struct FusedOp {
+        FusedHandler handler;
+        int16_t value;     // The @X constant, when there is one
+        uint16_t pc;       // ROM address of the first covered instruction
+        uint8_t length;    // Hack instructions covered
+    };
+
+    struct TranslatedBlock {
+        uint32_t firstOp;  // Index into fused_ops
+        uint16_t opCount;
+        uint16_t length;   // Hack instructions covered by the whole block
+    };
 
-    int16_t fetch();
-    void execute(DecodedInstruction instruction);
-    int16_t alu(bool is_M_bit, uint8_t operation);
+    const static uint16_t MAX_BLOCK_LENGTH = 64;
+
+    ExecutionMode execution_mode = ExecutionMode::INTERPRETED;
+    std::vector<int32_t> block_lookup;   // Start PC -> index into blocks, -1 if not translated yet (PC_SPACE entries)
+    std::vector<TranslatedBlock> blocks;
+    std::vector<FusedOp> fused_ops;
+
+    void clearBlockCache();
+    const TranslatedBlock& blockAt(uint16_t pc);
+    uint16_t fuseAt(uint16_t pc, FusedOp& op) const;
+    void executeBlock(const TranslatedBlock& block);
+    void executeFusedSlow(const FusedOp& op);
+    RunResult runBlocks(uint64_t maxCycles, int32_t targetPC);
+
+    // --- Run Loop Observers ---
+    // The interpreter loop is compiled once per observer type. An observer sees
+    // each instruction before it executes, with the A register it will use, and
+    // again afterwards with the new A and D, the RAM word at the old A and the
+    // next PC.
+    struct NullObserver {
+        static constexpr bool enabled = false;
+        void onInstruction(uint16_t, const MicroOp&, int16_t) {}
+        void afterInstruction(uint16_t, const MicroOp&, int16_t, int16_t, int16_t, int16_t, uint16_t) {}
+    };
+
+    template <bool Breakpoint, typename Observer>
+    RunResult interpret(uint64_t maxCycles, uint16_t targetPC, Observer& observer);
+
+    // --- Halt Detection ---
+    // Every taken backward jump counts down; at zero the loop just entered is
+    // probed once, with the delay doubling after each probe that finds progress.
+    const static uint32_t HALT_PROBE_FIRST = 16;
+    const static uint32_t HALT_PROBE_MAX   = 65536;
+    const static uint32_t HALT_PROBE_STEPS = 1024;  // Longest loop body a probe follows
+
+    bool halt_detection = true;
+    uint32_t halt_probe_interval = HALT_PROBE_FIRST;
+    uint32_t halt_probe_countdown = HALT_PROBE_FIRST;
+
+    void resetHaltProbe();
+    bool probeHalt(int32_t targetPC);
+    bool loopsForever(int32_t targetPC) const;
+    bool checkHalt(int32_t targetPC) {
+        return halt_detection && --halt_probe_countdown == 0 && probeHalt(targetPC);
+    }
+
+    // --- Loop Acceleration ---
+    // Backward jumps count down to a second kind of probe, which tries to prove
+    // that the loop just entered is a countdown: every iteration takes the same
+    // path and moves A, D and each RAM word by a fixed step. The iterations for
+    // which that stays true are then applied at once, as if executed.
+    const static uint32_t LOOP_PROBE_FIRST = 8;
+    const static uint32_t LOOP_PROBE_MAX   = 4096;
+
+    // One register or RAM word over the iterations of a loop: base + k * step
+    // at the start of iteration k, modulo 2^16
+    struct LoopValue {
+        int16_t base;
+        int16_t step;
+    };
+
+    struct LoopState {
+        LoopValue a;
+        LoopValue d;
+        std::vector<std::pair<uint16_t, LoopValue>> words;   // RAM words the iteration writes
+        uint32_t length = 0;       // Instructions in one iteration
+        uint64_t iterations = 0;   // Iterations from k = 0 that take the same path
+    };
+
+    bool loop_acceleration = false;
+    uint32_t loop_probe_interval = LOOP_PROBE_FIRST;
+    uint32_t loop_probe_countdown = LOOP_PROBE_FIRST;
+    uint64_t accelerated_cycles = 0;
+
+    uint64_t probeLoop(int32_t targetPC, uint64_t budget);
+    bool followIteration(int32_t targetPC, const LoopState& start, LoopState& end) const;
+    static bool evaluateLoop(AluOp op, LoopValue a, LoopValue d, LoopValue m, LoopValue& result);
+    // Cycles skipped, 0 when the loop was left alone
+    uint64_t checkLoop(int32_t targetPC, uint64_t budget) {
+        return loop_acceleration && --loop_probe_countdown == 0 ? probeLoop(targetPC, budget) : 0;
+    }
+
+    // --- Keyboard ---
+    // Runs are split at each pending key event so the loops above never look
+    // at the queue. A program polling KBD looks halted, so halt detection is
+    // off until the last event has been applied.
+    KeyboardInput* keyboard_input = nullptr;
+
+    void applyDueKeys();
+    template <typename Segment>
+    RunResult runWithKeyboard(uint64_t maxCycles, Segment runSegment);
 
 public:
     const static uint16_t RAM_BASE_ADDR    = 0;
@@ -65,21 +300,96 @@ public:
     const static uint16_t R_14          = 14;
     const static uint16_t R_15          = 15;
     const static size_t ROM_MAX_SIZE    = 32768;
+    static constexpr uint16_t KBD_ADDRESS = 24576;
+
+    // Screen memory map: 256 rows of 32 words, bit 0 of a word is its leftmost pixel
+    static constexpr uint16_t SCREEN_BASE      = 16384;
+    static constexpr uint16_t SCREEN_ROWS      = 256;
+    static constexpr uint16_t SCREEN_ROW_WORDS = 32;
+
+    // MicroOp::control bits
+    const static uint8_t JUMP_GT        = 0b000001;
+    const static uint8_t JUMP_EQ        = 0b000010;
+    const static uint8_t JUMP_LT        = 0b000100;
+    const static uint8_t DEST_M         = 0b001000;
+    const static uint8_t DEST_D         = 0b010000;
+    const static uint8_t DEST_A         = 0b100000;
     // --- Constructor & Initialization ---
     HackEmulator();
 
     void reset();
     int16_t peek(uint16_t addr) const;
 
+    // Restoring the snapshot most recently taken or restored copies only the
+    // RAM pages written since then; any other snapshot is copied in full.
+    HackSnapshot snapshot();
+    void restore(const HackSnapshot& snapshot);
+    size_t getDirtyPageCount() const;
+
+    // --- Screen ---
+    // Appends the screen rows written since the previous call (or since reset,
+    // restore or construction) in ascending order, and clears their marks.
+    void takeDirtyScreenRows(std::vector<uint16_t>& rows);
+    const int16_t* getScreenRow(uint16_t row) const { return &ram[SCREEN_BASE + row * SCREEN_ROW_WORDS]; }
+
     void loadProgram(const std::vector<int16_t>& instructions);
     DecodedInstruction decode(int16_t instruction);
-    // --- Execution Core (To be implemented later) ---
+    MicroOp getMicroOp(uint16_t addr) const { return predecoded_rom[addr]; }
+    // --- Execution Core ---
     void executeNextInstruction(); 
 
+    // Batched execution: each call executes at most maxCycles instructions.
+    // runUntil() checks its stop condition after every instruction.
+    RunResult run(uint64_t maxCycles);
+    RunResult runUntil(uint16_t targetPC, uint64_t maxCycles);
+    RunResult runUntil(const std::function<bool(const HackEmulator&)>& predicate, uint64_t maxCycles);
+
+    // Profiled runs always interpret, whatever the execution mode.
+    RunResult run(uint64_t maxCycles, ExecutionProfiler& profiler);
+    RunResult runUntil(uint16_t targetPC, uint64_t maxCycles, ExecutionProfiler& profiler);
+
+    // Traced runs also always interpret; see ExecutionTracer.
+    RunResult run(uint64_t maxCycles, ExecutionTracer& tracer);
+    RunResult runUntil(uint16_t targetPC, uint64_t maxCycles, ExecutionTracer& tracer);
+
+    // Runs collecting the instruction mix also interpret; see InstructionMix.
+    RunResult run(uint64_t maxCycles, InstructionMix& mix);
+    RunResult runUntil(uint16_t targetPC, uint64_t maxCycles, InstructionMix& mix);
+
+    // BLOCK_CACHE only affects run() and runUntil(pc); predicates always interpret.
+    void setExecutionMode(ExecutionMode mode) { execution_mode = mode; }
+    ExecutionMode getExecutionMode() const { return execution_mode; }
+
+    // Applies to instructions executed by the emulator; peek(), setRamValue() and
+    // the segment accessors are always checked.
+    void setMemoryMode(MemoryMode mode);
+    MemoryMode getMemoryMode() const { return memory_mode; }
+
+    // run() and runUntil(pc) stop with HALTED once the program re-enters a loop
+    // with A, D, PC and RAM unchanged, e.g. (END) @END 0;JMP or Sys.halt.
+    void setHaltDetection(bool enabled) { halt_detection = enabled; resetHaltProbe(); }
+    bool getHaltDetection() const { return halt_detection; }
+
+    // run() and runUntil(pc) skip countdown loops such as the one in Sys.wait,
+    // leaving RAM, registers and the cycle count exactly as if every iteration
+    // had run. Off by default; profiled and traced runs never skip.
+    void setLoopAcceleration(bool enabled);
+    bool getLoopAcceleration() const { return loop_acceleration; }
+    uint64_t getAcceleratedCycles() const { return accelerated_cycles; }   // Skipped since reset
+
+    // The emulator does not own the input; nullptr detaches it. Events are keyed
+    // by getCycleCount(), so rewinding with restore() does not replay them.
+    void setKeyboardInput(KeyboardInput* input) { keyboard_input = input; }
+    KeyboardInput* getKeyboardInput() const { return keyboard_input; }
+
+    // Sets KBD now, and records the key in the attached KeyboardInput if any
+    void pressKey(int16_t key);
+
     // --- Public Test/Debug Accessors ---
     int16_t getARegister() const { return a_register; }
     int16_t getDRegister() const { return d_register; }
     uint16_t getPC() const { return program_counter; }
+    uint64_t getCycleCount() const { return cycle_count; }
 
     void setARegister(int16_t value);
     void setDRegister(int16_t value);
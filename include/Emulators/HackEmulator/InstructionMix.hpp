@@ -0,0 +1,70 @@
+#ifndef INSTRUCTION_MIX_HPP
+#define INSTRUCTION_MIX_HPP
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+
+// Instruction mix of a run, broken down by the fields of the Hack instruction.
+// Mnemonics follow the assembler: comp "D+M", dest "AM", jump "JGE", and
+// "null" for an empty dest or jump field.
+struct InstructionMixSummary {
+    uint64_t instructions = 0;
+    uint64_t a_instructions = 0;
+    uint64_t a_constants = 0;          // @123
+    uint64_t a_symbols = 0;            // @LABEL, @SP, @R13, ...
+    uint64_t a_unclassified = 0;       // Not covered by a listing
+    uint64_t c_instructions = 0;
+
+    std::map<std::string, uint64_t> comp;
+    std::map<std::string, uint64_t> dest;
+    std::map<std::string, uint64_t> jump;
+    std::map<std::string, uint64_t> jump_taken;
+
+    // Conditional jumps only; 0;JMP and the like are always taken
+    uint64_t branches_taken = 0;
+    uint64_t branches_not_taken = 0;
+};
+
+// Collects the instruction mix of a HackEmulator run: emu.run(cycles, mix).
+// While running it only counts executions and taken jumps per ROM address;
+// the breakdown is derived from the loaded ROM when it is read, so it costs
+// about as much as ExecutionProfiler. A jump to the next address counts as not
+// taken.
+class InstructionMix {
+public:
+    static constexpr bool enabled = true;
+
+    InstructionMix();
+    void reset();
+
+    void onInstruction(uint16_t pc, const MicroOp&, int16_t) {
+        executions[pc & (ROM_SPACE - 1)]++;
+    }
+
+    void afterInstruction(uint16_t pc, const MicroOp&, int16_t, int16_t, int16_t, int16_t, uint16_t nextPC) {
+        taken[pc & (ROM_SPACE - 1)] += nextPC != static_cast<uint16_t>(pc + 1);
+    }
+
+    // emu must still hold the program that ran. With a listing written by
+    // HackAssembler, A-instructions are split into constants and symbols.
+    InstructionMixSummary summarize(const HackEmulator& emu, const std::string& listingPath = "") const;
+
+    // The summary as one JSON object
+    static void writeJson(std::ostream& out, const InstructionMixSummary& summary);
+
+    static std::string compMnemonic(AluOp op);
+    static std::string destMnemonic(uint8_t control);
+    static std::string jumpMnemonic(uint8_t control);
+
+private:
+    const static uint32_t ROM_SPACE = 32768;
+
+    std::vector<uint64_t> executions;
+    std::vector<uint64_t> taken;
+};
+
+#endif
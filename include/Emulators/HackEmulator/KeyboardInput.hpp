@@ -0,0 +1,52 @@
+#ifndef KEYBOARD_INPUT_HPP
+#define KEYBOARD_INPUT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The keyboard register takes key at the given cycle count, i.e. before the
+// instruction that would be number cycle + 1 since reset. 0 releases all keys.
+struct KeyEvent {
+    uint64_t cycle;
+    int16_t key;
+
+    bool operator==(const KeyEvent& other) const { return cycle == other.cycle && key == other.key; }
+};
+
+// Keyboard events for a HackEmulator, attached with setKeyboardInput(). Events
+// scheduled ahead of time are written to KBD by run() and runUntil() when the
+// emulator's cycle count reaches them; every event that reaches KBD, whether
+// scheduled or pressed live with HackEmulator::pressKey(), is appended to the
+// recording. Saving the recording and loading it into a fresh KeyboardInput
+// replays the session exactly.
+//
+// Files are text, one "<cycle> <key>" event per line in cycle order. Blank
+// lines and lines starting with '#' are ignored.
+class KeyboardInput {
+public:
+    KeyboardInput() = default;
+
+    // Events at the same cycle are applied in the order they were scheduled
+    void schedule(uint64_t cycle, int16_t key);
+
+    bool hasPending() const { return next < pending.size(); }
+    uint64_t getNextCycle() const { return pending[next].cycle; }
+    size_t getPendingCount() const { return pending.size() - next; }
+
+    // Removes and returns the next pending event. Only valid while hasPending().
+    KeyEvent takeNext() { return pending[next++]; }
+
+    void record(uint64_t cycle, int16_t key) { recording.push_back({ cycle, key }); }
+    const std::vector<KeyEvent>& getRecording() const { return recording; }
+
+    void save(const std::string& path) const;
+    static KeyboardInput load(const std::string& path);
+
+private:
+    std::vector<KeyEvent> pending;     // Sorted by cycle
+    size_t next = 0;                   // First event not applied yet
+    std::vector<KeyEvent> recording;
+};
+
+#endif
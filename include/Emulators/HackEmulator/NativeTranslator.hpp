@@ -0,0 +1,50 @@
+#ifndef NATIVE_TRANSLATOR_HPP
+#define NATIVE_TRANSLATOR_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Entry point of a translated program. Runs at most maxCycles instructions
+// from pc and returns how many ran; a, d and pc are updated in place. ram
+// holds 32768 words and is addressed like MemoryMode::FAST.
+using NativeProgram = uint64_t (*)(int16_t* ram, int16_t& a, int16_t& d, uint16_t& pc, uint64_t maxCycles);
+
+// Translates a Hack ROM ahead of time into a standalone C++ translation unit
+// defining one NativeProgram function.
+//
+// Each basic block becomes a labelled region of straight-line code. Jumps
+// whose target is the @X just before them go straight to the target's label;
+// computed jumps go through a switch on PC over the block leaders. A block
+// only runs when the cycle budget covers all of it, otherwise (and for PCs
+// outside the translated blocks) the generated code single-steps with an
+// embedded copy of the ROM, so cycle counts and final state match HackEmulator
+// exactly. A "(X) @X 0;JMP" loop is fast-forwarded to the end of the budget.
+class NativeTranslator {
+public:
+    NativeTranslator(const std::vector<int16_t>& rom, const std::string& functionName);
+
+    void write(std::ostream& out) const;
+
+    size_t getBlockCount() const { return leaders.size(); }
+
+private:
+    std::vector<int16_t> rom;
+    std::string functionName;
+    std::vector<uint16_t> leaders;       // Sorted block start addresses
+    std::vector<bool> is_leader;
+
+    void findLeaders();
+    bool staticTarget(uint16_t pc, uint16_t& target) const;
+    bool isHaltLoop(uint16_t leader, uint16_t end) const;
+
+    void writeStep(std::ostream& out) const;
+    void writeBlock(std::ostream& out, uint16_t leader, uint16_t end) const;
+    void writeInstruction(std::ostream& out, uint16_t pc, bool last, uint16_t end) const;
+
+    static bool isJump(int16_t instruction);
+    static std::string compExpression(uint16_t comp);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SCREEN_RECORDER_HPP
+#define SCREEN_RECORDER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+
+enum class FrameFormat {
+    PBM,               // Binary P4 bitmap, black pixels set
+    PPM,               // Binary P6 pixmap, black on white
+    RAW                // The 8K screen words as stored, little-endian
+};
+
+// Writes the Hack screen to numbered image files (frame_000000.pbm, ...).
+// The encoded frame is kept between captures and only the rows the emulator
+// reports as written since the previous capture are re-encoded.
+class ScreenRecorder {
+public:
+    ScreenRecorder(const std::string& outputDir, FrameFormat format, uint64_t cyclesPerFrame);
+
+    // Runs the emulator in slices of cyclesPerFrame, capturing a frame after
+    // each slice. Stops early if the program halts.
+    RunResult run(HackEmulator& emu, uint64_t maxCycles);
+
+    // Re-encodes the dirty rows and writes the next frame file
+    void captureFrame(HackEmulator& emu);
+
+    const std::vector<uint8_t>& getFrame() const { return frame; }
+    size_t getFrameCount() const { return frameCount; }
+    size_t getLastDirtyRowCount() const { return lastDirtyRows; }
+
+private:
+    const static uint16_t SCREEN_WIDTH = 512;
+
+    std::string outputDir;
+    FrameFormat format;
+    uint64_t cyclesPerFrame;
+
+    std::vector<uint8_t> frame;        // Header followed by the encoded rows
+    size_t headerSize = 0;
+    size_t rowSize = 0;
+    size_t frameCount = 0;
+    size_t lastDirtyRows = 0;
+    std::vector<uint16_t> dirtyRows;
+
+    void encodeRow(const int16_t* words, uint8_t* out) const;
+    std::string framePath(size_t index) const;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef TRACE_RING_BUFFER_HPP
+#define TRACE_RING_BUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Fixed-size lock-free queue for one producer thread and one consumer thread.
+// head and tail only ever grow; a slot index is the counter masked by the
+// power-of-two capacity. The producer keeps a cached copy of tail and only
+// reloads it when the buffer looks full; the consumer pops in batches.
+template <typename T>
+class TraceRingBuffer {
+public:
+    explicit TraceRingBuffer(size_t minCapacity) {
+        size_t capacity = 1;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        slots.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    size_t capacity() const { return mask + 1; }
+    size_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+    // --- Producer ---
+
+    bool tryPush(const T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - producer_tail > mask) {
+            producer_tail = tail.load(std::memory_order_acquire);
+            if (h - producer_tail > mask) {
+                return false;
+            }
+        }
+        slots[h & mask] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Drops the oldest item when full. Only valid while no consumer thread is
+    // running, since it advances tail itself.
+    void pushOverwrite(const T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (h - t > mask) {
+            tail.store(t + 1, std::memory_order_relaxed);
+        }
+        slots[h & mask] = item;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // --- Consumer ---
+
+    // Moves up to maxItems of the oldest items into out, returns how many
+    size_t popBatch(T* out, size_t maxItems) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t count = head.load(std::memory_order_acquire) - t;
+        if (count > maxItems) {
+            count = maxItems;
+        }
+        for (size_t i = 0; i < count; i++) {
+            out[i] = slots[(t + i) & mask];
+        }
+        tail.store(t + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+
+    // Producer and consumer counters live on separate cache lines
+    alignas(64) std::atomic<size_t> head{0};     // Next slot to write
+    size_t producer_tail = 0;                    // Producer's last view of tail
+    alignas(64) std::atomic<size_t> tail{0};     // Next slot to read
+};
+
+#endif
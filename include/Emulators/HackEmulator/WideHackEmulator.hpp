@@ -0,0 +1,72 @@
+#ifndef WIDE_HACK_EMULATOR_HPP
+#define WIDE_HACK_EMULATOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+
+// Runs Lanes independent Hack machines that share one ROM, in lockstep. Each
+// step picks the lowest PC among the running lanes and executes that one
+// instruction for every lane sitting on it, with the other lanes masked off,
+// so lanes that split at a branch merge again once the lagging ones catch up.
+// Registers are kept as arrays of one value per lane and RAM is interleaved
+// by lane (word addr of lane l at addr * Lanes + l), which lets the compiler
+// vectorize the per-lane loops.
+//
+// Memory follows MemoryMode::FAST. A lane stops with HALTED when it reaches
+// the first instruction of a "(X) @X 0;JMP" loop. Instantiated for 8 and 16
+// lanes.
+template <size_t Lanes>
+class WideHackEmulator {
+public:
+    static constexpr size_t LANES = Lanes;
+
+    WideHackEmulator();
+
+    void reset();
+    void loadProgram(const std::vector<int16_t>& instructions);
+
+    // Runs every lane until it has executed maxCycles instructions in this
+    // call or halts. Results are per lane.
+    std::array<RunResult, Lanes> run(uint64_t maxCycles);
+
+    int16_t peek(size_t lane, uint16_t addr) const;
+    void setRamValue(size_t lane, uint16_t addr, int16_t value);
+    // Sets addr to the same value in every lane
+    void setRamValue(uint16_t addr, int16_t value);
+
+    int16_t getARegister(size_t lane) const { return a_register[lane]; }
+    int16_t getDRegister(size_t lane) const { return d_register[lane]; }
+    uint16_t getPC(size_t lane) const { return program_counter[lane]; }
+    uint64_t getCycleCount(size_t lane) const { return cycle_count[lane]; }
+
+    // Lockstep steps taken since reset; cycles / steps is the average number of
+    // lanes sharing an instruction
+    uint64_t getStepCount() const { return step_count; }
+
+private:
+    const static uint32_t RAM_SPACE = 32768;
+
+    using Mask = std::array<int16_t, Lanes>;   // -1 for lanes taking part in a step, 0 otherwise
+
+    std::vector<int16_t> rom;                  // ROM_MAX_SIZE words
+    std::vector<uint8_t> halt_loop;            // 1 for ROM addresses starting a "(X) @X 0;JMP" loop
+    std::vector<int16_t> ram;                  // RAM_SPACE * Lanes words, interleaved by lane
+
+    std::array<int16_t, Lanes> a_register;
+    std::array<int16_t, Lanes> d_register;
+    std::array<uint16_t, Lanes> program_counter;
+    std::array<uint64_t, Lanes> cycle_count;
+    uint64_t step_count = 0;
+
+    void runChunk(std::array<int32_t, Lanes>& remaining, std::array<bool, Lanes>& halted);
+    static size_t leadLane(const Mask& mask);
+    bool sameProgramCounter(const Mask& mask, uint16_t pc) const;
+    void checkLane(size_t lane) const;
+
+    void executeA(int16_t instruction, const Mask& mask);
+    bool executeC(int16_t instruction, const Mask& mask);   // True if the instruction can jump
+};
+
+#endif
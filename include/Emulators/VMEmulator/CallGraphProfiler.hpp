@@ -0,0 +1,109 @@
+#ifndef CALL_GRAPH_PROFILER_HPP
+#define CALL_GRAPH_PROFILER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VMEmulator;
+
+// Follows every call and return while a VMEmulator runs with it:
+// vm.executeInstructions(steps, profiler). Counts calls and VM commands per
+// function, inclusive and exclusive, and per call stack for flamegraphs.
+// Runs without a profiler are compiled without the hooks.
+//
+// Functions are known by their entry address; the report methods take the
+// emulator to name them. Code outside any function, such as a raw program
+// before its first function declaration, counts as "(top)". Calls answered
+// by an intrinsic count as calls that run no commands.
+class CallGraphProfiler {
+public:
+    static constexpr bool enabled = true;
+
+    CallGraphProfiler();
+    void reset();
+
+    // Called by the emulator. step counts commands since the run started;
+    // a call's own command belongs to the caller, a return's to the callee.
+    void onStart(int32_t function);
+    void onCall(uint16_t function, uint64_t step) {
+        attribute(step);
+        push(function);
+    }
+    void onReturn(uint64_t step) {
+        attribute(step);
+        pop();
+    }
+    void onStop(uint64_t step) {
+        attribute(step);
+        last_step = 0;
+    }
+
+    struct FunctionStats {
+        std::string name;
+        uint64_t calls;
+        uint64_t inclusive;   // Commands run while the function was on the stack
+        uint64_t exclusive;   // Commands of the function itself
+    };
+
+    // Every function seen, by exclusive count, highest first
+    std::vector<FunctionStats> getFunctions(const VMEmulator& vm) const;
+    uint64_t getTotalInstructions() const { return total; }
+
+    // One "caller;...;callee count" line per call stack, as flamegraph.pl and
+    // speedscope read it
+    void writeFolded(std::ostream& out, const VMEmulator& vm) const;
+    void writeReport(std::ostream& out, const VMEmulator& vm, size_t top = 20) const;
+
+private:
+    static constexpr uint32_t NO_FUNCTION = 0xFFFFFFFF;
+    static constexpr uint32_t NO_NODE = 0xFFFFFFFF;
+    static constexpr uint32_t ADDRESS_SPACE = 32768;
+
+    struct Function {
+        uint32_t address;
+        uint64_t calls = 0;
+        uint64_t inclusive = 0;
+        uint64_t exclusive = 0;
+        uint32_t active = 0;         // Frames on the stack
+        uint64_t outermostEntry = 0; // total when the first of them was entered
+    };
+    // One distinct call stack
+    struct Node {
+        uint32_t parent;   // NO_NODE for the outermost frame
+        uint32_t function;
+        uint64_t exclusive = 0;
+    };
+    struct Frame {
+        uint32_t function;
+        uint32_t node;
+    };
+
+    std::vector<uint32_t> function_ids;   // By address; NO_FUNCTION until seen
+    std::vector<Function> functions;
+    std::vector<Node> nodes;
+    std::unordered_map<uint64_t, uint32_t> children;   // (parent << 32 | function) -> node
+    std::vector<Frame> stack;
+    uint64_t total = 0;
+    uint64_t last_step = 0;
+
+    uint32_t functionId(uint32_t address);
+    void push(uint32_t address);
+    void pop();
+
+    void attribute(uint64_t step) {
+        uint64_t steps = step - last_step;
+        last_step = step;
+        total += steps;
+        if (!stack.empty()) {
+            functions[stack.back().function].exclusive += steps;
+            nodes[stack.back().node].exclusive += steps;
+        }
+    }
+
+    std::string nameOf(uint32_t function, const VMEmulator& vm) const;
+};
+
+#endif
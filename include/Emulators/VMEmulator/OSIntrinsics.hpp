@@ -0,0 +1,26 @@
+#ifndef OS_INTRINSICS_HPP
+#define OS_INTRINSICS_HPP
+
+#include <cstdint>
+
+class VMEmulator;
+
+// Host versions of the hottest OSLib functions. Each one leaves RAM below the
+// stack pointer, temp 0 included, and the return value exactly as the VM
+// code compiled from OSLib/ would, so they read and write the statics of
+// Math, Memory and Screen at the indices the compiler gives them. Paths that
+// end in Sys.error are left to the VM code.
+class OSIntrinsics {
+public:
+    // Registers all of them with vm, disabled
+    static void registerAll(VMEmulator& vm);
+
+    static bool mathMultiply(VMEmulator& vm, int16_t* ram, const int16_t* args, int16_t& result);
+    static bool mathDivide(VMEmulator& vm, int16_t* ram, const int16_t* args, int16_t& result);
+    static bool memoryAlloc(VMEmulator& vm, int16_t* ram, const int16_t* args, int16_t& result);
+    static bool stringAppendChar(VMEmulator& vm, int16_t* ram, const int16_t* args, int16_t& result);
+    static bool screenClearScreen(VMEmulator& vm, int16_t* ram, const int16_t* args, int16_t& result);
+    static bool screenDrawHorizontalLine(VMEmulator& vm, int16_t* ram, const int16_t* args, int16_t& result);
+};
+
+#endif
@@ -1,6 +1,7 @@
-#ifndef SYMBOL_TABLE_HPP
-#define SYMBOL_TABLE_HPP
+#ifndef VM_SYMBOL_TABLE_HPP
+#define VM_SYMBOL_TABLE_HPP
 
+#include <map>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -8,6 +9,8 @@
 struct FileRange {
     int16_t startAddress;
     std::string fileName;
+    // Where the file's static segment starts, relative to RAM[16]
+    uint16_t staticBase;
 };
 
 struct FunctionEntry {
@@ -21,16 +24,24 @@ public:
     void addFunction(const std::string& functionName, int16_t address, int16_t locals);
     
     // Called once per file at the start of loading
-    void registerFileRange(const std::string& fileName, int16_t startAddress);
+    void registerFileRange(const std::string& fileName, int16_t startAddress, uint16_t staticBase = 0);
 
     int16_t getAddressFromLabel(int16_t currentPC, const std::string& labelName) const;
     FunctionEntry getFunctionAddress(const std::string& functionName) const;
+    bool hasFunction(const std::string& functionName) const { return functions.count(functionName) != 0; }
+    uint16_t getStaticBase(const std::string& fileName) const;
+    // Address of the function whose code holds pc, or -1 for code before
+    // the first function
+    int16_t getFunctionStart(int16_t pc) const;
+    // Name of the function starting at address, or empty
+    std::string getFunctionName(int16_t address) const;
     void clear();
 
 private:
     // fileName -> { labelName -> address }
     std::unordered_map<std::string, std::unordered_map<std::string, int16_t>> labels;
     std::unordered_map<std::string, FunctionEntry> functions;
+    std::map<int16_t, std::string> functionNames;
 
     // Small vector: {0, "Main"}, {20, "Sys"}, {50, "Class"}
     std::vector<FileRange> fileRanges;
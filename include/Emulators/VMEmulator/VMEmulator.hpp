@@ -2,69 +2,103 @@
 #define VM_EMULATOR_HPP
 
 #include <vector>
+#include <map>
+#include <string>
 #include <cstdint>
 #include <stdexcept>
-#include <functional>
-#include <unordered_map>
 #include <algorithm>
 #include "VMParser.hpp"
 #include "SymbolTable.hpp"
-
-
-enum class InstructionType {
-    PUSH,
-    POP,
-    UNARY_ARITHMETIC,
-    BINARY_ARITHMETIC,
-    GOTO,
-    IF_GOTO,
-    FUNCTION_CALL,
-    RETURN
+#include "VMInstruction.hpp"
+
+// How the interpreter core gets from one instruction to the next. THREADED
+// jumps from the end of each handler straight to the next one through a
+// table of label addresses (computed goto); with compilers that lack the
+// extension it behaves like SWITCH.
+enum class VMDispatch {
+    SWITCH,
+    THREADED
 };
 
-enum class Segment {
-    CONSTANT,
-    LOCAL,
-    ARG,
-    POINTER,
-    THIS,
-    THAT,
-    STATIC,
-    TEMP
+enum class VMStopReason {
+    STEP_LIMIT,        // maxSteps commands were executed
+    HALTED,            // The program called Sys.halt or reached a goto to itself
+    END_OF_PROGRAM,    // The PC ran past the last command
+    ERROR              // The program went wrong; see VMRunResult::error
 };
 
-struct DecodedInstruction {
-    InstructionType type;
-    Segment segment;
-    std::string command;
-    uint16_t value;
+struct VMRunResult {
+    uint64_t steps;            // Commands executed by this call
+    VMStopReason reason;
+    uint16_t pc;               // PC of the next command to execute
+    uint16_t peakStackDepth;   // Most words on the stack above RAM[256] during the run
+    std::string error;
 };
 
+class VMEmulator;
+class CallGraphProfiler;
+
+// Host implementation of a VM function, run by call in place of the
+// function's VM code. args points at the arguments the caller pushed; the
+// function may read and write ram and stores its return value in result.
+// Returning false runs the VM code instead, e.g. on paths that call Sys.error.
+using VMIntrinsic = bool (*)(VMEmulator& vm, int16_t* ram, const int16_t* args, int16_t& result);
 
 class VMEmulator {
 private:
     std::vector<int16_t> ram;
-    std::vector<std::string> rom;
+    // Packed by the parser at load time; see VMInstruction
+    std::vector<VMInstruction> rom;
+    // rom with superinstructions; see VMParser::fuse
+    std::vector<VMInstruction> fused_rom;
+    bool superinstructions = false;
+    bool stack_caching = false;
     uint16_t program_counter = 0;
     VMParser parser;
     SymbolTable symbolTable;
-    std::unordered_map<std::string, std::function<void()>> unaryOps;
-    std::unordered_map<std::string, std::function<void()>> binaryOps;
-    std::unordered_map<std::string, Segment> segmentMap;
-
-    std::string fetch();
-    void execute(DecodedInstruction decoded);
-    void executePush(DecodedInstruction decoded);
-    void executePop(DecodedInstruction decoded);
-    void executeUnaryArithmetic(DecodedInstruction decoded);
-    void executeBinaryArithmetic(DecodedInstruction decoded);
-    void executeFunctionCall(DecodedInstruction decoded);
-    void executeReturn(DecodedInstruction decoded);
-    void stackPush(uint16_t val);
-    uint16_t stackPop();
-
-    void initDispatchTables();
-    void initSegmentMap();
+    VMDispatch dispatch = VMDispatch::THREADED;
+
+    struct IntrinsicEntry {
+        VMIntrinsic implementation;
+        bool enabled;
+    };
+    std::map<std::string, IntrinsicEntry> intrinsics;
+    // Enabled intrinsics by function address; empty when none is
+    std::vector<VMIntrinsic> boundIntrinsics;
+    void bindIntrinsics();
+
+    // Lays out the frame of call Sys.init 0 like the translator's bootstrap
+    // and starts there; returning from it runs off the end of the program
+    void bootstrap();
+
+    // What makes run() stop early besides the step budget
+    struct StopConditions {
+        uint32_t haltAddress;   // Calls to this address halt
+        int32_t stackLimit;     // A call leaving SP above this is a stack overflow
+        bool haltOnSelfGoto;    // A goto to its own address halts
+    };
+    static constexpr StopConditions NO_STOP_CONDITIONS = { 0xFFFFFFFF, 0x7FFFFFFF, false };
+    // Keeps stack accesses with a bad SP inside the 32K words of RAM
+    static constexpr uint16_t ADDRESS_MASK = 0x7FFF;
+    VMStopReason stop_reason = VMStopReason::STEP_LIMIT;
+    std::string stop_error;
+    int32_t peak_stack_pointer = 0;
+
+    struct NullObserver {
+        static constexpr bool enabled = false;
+        void onCall(uint16_t, uint64_t) {}
+        void onReturn(uint64_t) {}
+        void onStop(uint64_t) {}
+    };
+
+    // The interpreter core, compiled once per dispatch style, stack mode and
+    // observer type. An observer sees every call and return with the number
+    // of commands run so far, and the end of the run.
+    template <bool Threaded, bool CachedStack, typename Observer>
+    uint64_t interpret(uint64_t maxSteps, Observer& observer, const StopConditions& stop = NO_STOP_CONDITIONS);
+    // The core for the current dispatch and stack mode
+    template <typename Observer>
+    uint64_t interpretSelected(uint64_t maxSteps, Observer& observer, const StopConditions& stop = NO_STOP_CONDITIONS);
 
 public:
     const static uint16_t RAM_BASE_ADDR    = 0;
@@ -78,13 +112,73 @@ public:
     const static uint16_t THAT_POINTER     = 4;
     const static uint16_t TEMP_POINTER     = 5;
 
+    const static uint16_t STACK_BASE_ADDR  = 256;
+    const static uint16_t HEAP_BASE_ADDR   = 2048;
+
     VMEmulator();
     
     void loadRawProgram(const std::vector<std::string>& instructions);
+    // Loads a .vm file or a directory of them. Each file gets its own static
+    // segment. If Sys.init is defined, execution starts in it with SP = 256.
     void loadProgram(const std::string& path);
 
     DecodedInstruction decode (std::string instruction);
+    const std::vector<VMInstruction>& getBytecode() const { return rom; }
     void executeNextInstruction();
+
+    // Executes up to count instructions and returns how many ran; fewer when
+    // the PC runs past the end of the program
+    uint64_t executeInstructions(uint64_t count);
+    // Same, reporting calls and returns to profiler
+    uint64_t executeInstructions(uint64_t count, CallGraphProfiler& profiler);
+
+    // Runs until maxSteps commands have executed or the program stops: it
+    // calls Sys.halt or reaches a goto to itself (or is already at either),
+    // runs past its last command, returns to an address outside the program,
+    // or a call grows the stack into the heap at RAM[2048].
+    VMRunResult run(uint64_t maxSteps);
+
+    // True when the compiler supports computed goto
+    static const bool THREADED_DISPATCH_SUPPORTED;
+    void setDispatch(VMDispatch mode) { dispatch = mode; }
+    VMDispatch getDispatch() const { return dispatch; }
+
+    // Runs common compiler-emitted sequences as single superinstructions.
+    // RAM, PC and step counts match plain execution exactly, including when
+    // a step budget ends inside a sequence. Off by default.
+    void setSuperinstructions(bool enabled) { superinstructions = enabled; }
+    bool getSuperinstructions() const { return superinstructions; }
+
+    // Keeps SP and the top of the stack in host registers while running,
+    // writing them back to RAM around call and return and when the run
+    // ends. RAM, PC and step counts below SP match the uncached core; words
+    // above SP, which no longer belong to the stack, may differ. Off by
+    // default.
+    void setStackCaching(bool enabled) { stack_caching = enabled; }
+    bool getStackCaching() const { return stack_caching; }
+
+    // --- Intrinsics ---
+    // A registered intrinsic starts disabled. The constructor registers the
+    // OSLib functions in OSIntrinsics. Enabling one for a function the program
+    // does not define has no effect until a program that does is loaded.
+    void registerIntrinsic(const std::string& functionName, VMIntrinsic implementation);
+    // Throws for names with no registered intrinsic
+    void setIntrinsic(const std::string& functionName, bool enabled);
+    void setIntrinsics(bool enabled);
+    bool isIntrinsicEnabled(const std::string& functionName) const;
+    std::vector<std::string> getIntrinsicNames() const;
+
+    // Name of the function starting at address, or empty
+    std::string getFunctionName(uint16_t address) const {
+        return symbolTable.getFunctionName(static_cast<int16_t>(address));
+    }
+    uint16_t getProgramCounter() const { return program_counter; }
+
+    // RAM address of static i of a loaded file (its name without .vm)
+    uint16_t getStaticAddress(const std::string& fileName, uint16_t i) const {
+        return static_cast<uint16_t>(STATIC_BASE_ADDR + symbolTable.getStaticBase(fileName) + i);
+    }
+
     int16_t peek(uint16_t addr) const;
     int16_t peekStack();
     void poke(uint16_t addr, int16_t value);
@@ -0,0 +1,94 @@
+#ifndef VM_INSTRUCTION_HPP
+#define VM_INSTRUCTION_HPP
+
+#include <cstdint>
+#include <string>
+
+enum class InstructionType : uint8_t {
+    PUSH,
+    POP,
+    UNARY_ARITHMETIC,
+    BINARY_ARITHMETIC,
+    GOTO,
+    IF_GOTO,
+    FUNCTION_CALL,
+    RETURN
+};
+
+enum class Segment : uint8_t {
+    CONSTANT,
+    LOCAL,
+    ARG,
+    POINTER,
+    THIS,
+    THAT,
+    STATIC,
+    TEMP
+};
+
+// What the interpreter dispatches on. Push and pop have one opcode per
+// segment, in Segment order; there is no pop to constant.
+enum class Opcode : uint8_t {
+    PUSH_CONSTANT,
+    PUSH_LOCAL,
+    PUSH_ARG,
+    PUSH_POINTER,
+    PUSH_THIS,
+    PUSH_THAT,
+    PUSH_STATIC,
+    PUSH_TEMP,
+    POP_LOCAL,
+    POP_ARG,
+    POP_POINTER,
+    POP_THIS,
+    POP_THAT,
+    POP_STATIC,
+    POP_TEMP,
+    ADD,
+    SUB,
+    NEG,
+    EQ,
+    GT,
+    LT,
+    AND,
+    OR,
+    NOT,
+    GOTO,
+    IF_GOTO,
+    CALL,
+    RETURN,
+
+    // Superinstructions, only found in code from VMParser::fuse(). Each one
+    // replaces the first command of the sequence it stands for.
+    ARRAY_READ,     // add; pop pointer 1; push that 0
+    ARRAY_WRITE,    // pop temp k; pop pointer 1; push temp k; pop that 0
+    NOT_IF_GOTO,    // not; if-goto target
+    PUSH_NOT,       // push constant c; not
+    DISCARD,        // pop temp k right after a call; return performs it
+    COUNT
+};
+
+// One VM command as the parser packs it at load time:
+//   push/pop        segment, value = index; for static, plus the
+//                   file's static base
+//   goto/if-goto    target = label address
+//   call            target = function address, value = nArgs,
+//                   locals = the callee's local count
+// Until VMParser::link() runs, target holds the symbol id of the name.
+struct VMInstruction {
+    Opcode opcode = Opcode::RETURN;
+    Segment segment = Segment::CONSTANT;
+    uint16_t value = 0;
+    uint16_t target = 0;
+    uint16_t locals = 0;
+};
+
+// Readable form of one command, as returned by VMEmulator::decode()
+struct DecodedInstruction {
+    InstructionType type;
+    Segment segment;
+    std::string command;
+    uint16_t value;
+};
+
+#endif
@@ -2,23 +2,85 @@
 #define VM_PARSER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <filesystem>
 #include "Emulators/FileLoader.hpp"
 #include "Emulators/VMEmulator/SymbolTable.hpp"
+#include "Emulators/VMEmulator/VMInstruction.hpp"
+
+// One file tokenized on its own. Addresses and static indices are relative
+// to the file and branch and call targets index its own symbols, so files
+// can be parsed on any thread and merged afterwards.
+struct ParsedFile {
+    struct Declaration {
+        std::string name;
+        uint16_t address;
+        int16_t locals;   // Functions only
+    };
+
+    std::string name;
+    std::vector<VMInstruction> code;
+    std::vector<std::string> symbols;
+    std::vector<Declaration> labels;
+    std::vector<Declaration> functions;
+    uint16_t staticCount = 0;
+};
 
 class VMParser {
 public:
     VMParser() = default;
     void loadFile(const std::string& filepath, SymbolTable& table);
+    // Same as loadFile for lines already in memory, as one file. Static
+    // indices are relocated past the statics of earlier files.
+    void loadLines(const std::string& fileName, const std::vector<std::string>& lines, SymbolTable& table);
+    // Loads every .vm file in a directory. Files are read and tokenized on
+    // up to threads threads (0 for one per core) and merged in filename
+    // order, so the program is the same on every run and file system.
+    void loadDirectory(const std::string& path, SymbolTable& table, size_t threads = 0);
+
+    // Tokenizes a whole file's text; safe to call from several threads
+    static ParsedFile parse(const std::string& fileName, std::string_view text);
+    // Appends a parsed file to the program, moving its addresses past the
+    // code and its statics past the statics loaded so far
+    void merge(const ParsedFile& file, SymbolTable& table);
+    // Resolves every branch and call target once all files are loaded.
+    // Throws on labels or functions that are not defined.
+    void link(const SymbolTable& table);
     void clear();
-    const std::vector<std::string>& getInstructions() const { return instructions; }
     std::string cleanLine(const std::string& line);
-    
+
+    // Packs one command (no label or function declarations) and appends it
+    void addInstruction(const std::string& line);
+
+    const std::vector<VMInstruction>& getBytecode() const { return bytecode; }
+
+    // Label and function names, indexed by VMInstruction::target
+    const std::vector<std::string>& getSymbols() const { return symbols; }
+
+    // Packs a cleaned command; goto/if-goto/call return their label or
+    // function name in symbol. Throws on anything that is not a VM command.
+    static VMInstruction encode(std::string_view line, std::string& symbol);
+    // Copy of linked code with the command sequences CodeGenerator emits most
+    // replaced by superinstructions. Only the first slot of a sequence
+    // changes, so addresses stay the same and jumps into one still work.
+    static std::vector<VMInstruction> fuse(const std::vector<VMInstruction>& code);
+
+    static const char* mnemonic(Opcode op);
+    // Of an opcode encode() produces
+    static InstructionType typeOf(Opcode op);
+
 private:
-    FileLoader loader;
-    std::vector<std::string> instructions;
+    std::vector<VMInstruction> bytecode;
+    std::vector<std::string> symbols;
+    std::unordered_map<std::string, uint16_t> symbolIds;
+    // Static words used by the files loaded so far; each file's statics
+    // follow those of the files before it
+    uint16_t staticCount = 0;
+
+    uint16_t internSymbol(const std::string& name);
+    static void parseLine(ParsedFile& file, std::string_view line);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -77,4 +77,19 @@ std::vector<std::string> FileLoader::loadRawLines(const std::string& filepath) {
     }
     
     return lines;
+}
+
+std::string FileLoader::loadText(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + filepath);
+    }
+
+    std::string text(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(text.data(), static_cast<std::streamsize>(text.size()))) {
+        throw std::runtime_error("Failed to read file: " + filepath);
+    }
+    return text;
 }
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "Emulators/HackEmulator/BatchRunner.hpp"
+#include "Emulators/FileLoader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // --- Work-stealing Queues ---
+
+    class WorkQueues {
+    public:
+        explicit WorkQueues(size_t workers) : queues(workers) {}
+
+        void push(size_t worker, size_t job) {
+            queues[worker].jobs.push_back(job);
+        }
+
+        bool pop(size_t worker, size_t& job) {
+            {
+                Queue& own = queues[worker];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.jobs.empty()) {
+                    job = own.jobs.back();
+                    own.jobs.pop_back();
+                    return true;
+                }
+            }
+            for (size_t i = 1; i < queues.size(); i++) {
+                Queue& victim = queues[(worker + i) % queues.size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.jobs.empty()) {
+                    job = victim.jobs.front();
+                    victim.jobs.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<size_t> jobs;
+        };
+        std::vector<Queue> queues;
+    };
+
+    std::string readFile(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    std::string stripComments(const std::string& text) {
+        return std::regex_replace(text, std::regex("//[^\n]*"), "");
+    }
+
+    // --- Script Parsing ---
+
+    // A script command split into words; a repeat also carries its block
+    struct ScriptCommand {
+        std::vector<std::string> words;
+        std::vector<ScriptCommand> body;
+    };
+
+    // Commands end at ',' or ';', and braces are commands of their own
+    std::vector<std::string> splitCommands(const std::string& text) {
+        std::vector<std::string> commands;
+        std::string current;
+        auto flush = [&]() {
+            size_t start = current.find_first_not_of(" \t\r\n");
+            if (start != std::string::npos) {
+                commands.push_back(current.substr(start, current.find_last_not_of(" \t\r\n") - start + 1));
+            }
+            current.clear();
+        };
+        for (char c : text) {
+            if (c == ',' || c == ';') {
+                flush();
+            } else if (c == '{' || c == '}') {
+                flush();
+                commands.push_back(std::string(1, c));
+            } else {
+                current += c;
+            }
+        }
+        flush();
+        return commands;
+    }
+
+    std::vector<ScriptCommand> parseBlock(const std::vector<std::string>& commands, size_t& pos, bool nested,
+                                          const std::string& path) {
+        std::vector<ScriptCommand> block;
+        while (pos < commands.size()) {
+            const std::string& text = commands[pos++];
+            if (text == "}") {
+                if (!nested) {
+                    throw std::runtime_error("Unmatched '}' in " + path);
+                }
+                return block;
+            }
+            if (text == "{") {
+                throw std::runtime_error("Block without a repeat in " + path);
+            }
+
+            ScriptCommand command;
+            std::stringstream words(text);
+            std::string word;
+            while (words >> word) {
+                command.words.push_back(word);
+            }
+            if (command.words[0] == "repeat") {
+                if (command.words.size() != 2 || pos == commands.size() || commands[pos] != "{") {
+                    throw std::runtime_error("repeat needs a count and a block in " + path);
+                }
+                pos++;
+                command.body = parseBlock(commands, pos, true, path);
+            }
+            block.push_back(command);
+        }
+        if (nested) {
+            throw std::runtime_error("Unterminated repeat block in " + path);
+        }
+        return block;
+    }
+
+    // Trimmed cells of a "| a | b |" row of a .cmp file
+    std::vector<std::string> splitCells(const std::string& line) {
+        std::vector<std::string> cells;
+        std::stringstream row(line);
+        std::string cell;
+        while (std::getline(row, cell, '|')) {
+            size_t start = cell.find_first_not_of(" \t\r");
+            if (start != std::string::npos) {
+                cells.push_back(cell.substr(start, cell.find_last_not_of(" \t\r") - start + 1));
+            }
+        }
+        return cells;
+    }
+}
+
+BatchRunner::BatchRunner(size_t threads, ExecutionMode mode)
+    : threads(std::max<size_t>(threads, 1)), mode(mode)
+{
+
+}
+
+std::vector<BatchResult> BatchRunner::run(const std::vector<BatchJob>& jobs) const {
+    std::vector<BatchResult> results(jobs.size());
+    size_t workers = std::min(threads, std::max<size_t>(jobs.size(), 1));
+
+    WorkQueues queues(workers);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        queues.push(i % workers, i);
+    }
+
+    // Each job writes only its own result slot, so results need no lock
+    auto worker = [&](size_t id) {
+        FileLoader loader;
+        HackEmulator emu;
+        emu.setExecutionMode(mode);
+
+        size_t index;
+        while (queues.pop(id, index)) {
+            const BatchJob& job = jobs[index];
+            try {
+                results[index] = runJob(job, emu, loader.loadFile(job.programPath));
+            } catch (const std::exception& e) {
+                results[index].name = job.name;
+                results[index].failures.push_back(e.what());
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t id = 1; id < workers; id++) {
+        pool.emplace_back(worker, id);
+    }
+    worker(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    return results;
+}
+
+BatchResult BatchRunner::runJob(const BatchJob& job, HackEmulator& emu, const std::vector<int16_t>& program) {
+    BatchResult result;
+    result.name = job.name;
+    auto start = std::chrono::steady_clock::now();
+
+    emu.reset();
+    emu.loadProgram(program);
+
+    try {
+        for (size_t i = 0; i < job.steps.size(); i++) {
+            const BatchStep& step = job.steps[i];
+            for (const auto& [address, value] : step.setRam) {
+                emu.setRamValue(address, value);
+            }
+            RunResult run = emu.run(step.cycles);
+            result.run = { result.run.cycles + run.cycles, run.reason, run.pc };
+            for (const RamCheck& check : step.checks) {
+                int16_t actual = emu.peek(check.address);
+                if (actual != check.expected) {
+                    result.failures.push_back("Output " + std::to_string(i + 1) + ": RAM[" + std::to_string(check.address) +
+                                              "] expected " + std::to_string(check.expected) + ", got " + std::to_string(actual));
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        result.failures.push_back(e.what());
+    }
+
+    result.passed = result.failures.empty();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// --- Test Scripts ---
+
+BatchJob BatchRunner::loadTestScript(const std::string& tstPath) {
+    fs::path script(tstPath);
+    std::vector<std::string> commands = splitCommands(stripComments(readFile(tstPath)));
+    size_t pos = 0;
+    std::vector<ScriptCommand> block = parseBlock(commands, pos, false, tstPath);
+
+    BatchJob job;
+    job.name = script.stem().string();
+
+    // Program
+    auto load = std::find_if(block.begin(), block.end(), [](const ScriptCommand& command) {
+        return command.words[0] == "load";
+    });
+    if (load == block.end() || load->words.size() != 2) {
+        throw std::runtime_error("No load command in " + tstPath);
+    }
+    fs::path program = script.parent_path() / fs::path(load->words[1]).replace_extension(".hack");
+    if (!fs::exists(program)) {
+        std::vector<fs::path> candidates;
+        for (const auto& entry : fs::directory_iterator(script.parent_path())) {
+            if (entry.path().extension() == ".hack") {
+                candidates.push_back(entry.path());
+            }
+        }
+        if (candidates.size() != 1) {
+            throw std::runtime_error("Cannot find the program for " + tstPath);
+        }
+        program = candidates.front();
+    }
+    job.programPath = program.string();
+
+    // Expected values: a header row for each output-list, a data row for each output
+    fs::path cmp = fs::path(tstPath).replace_extension(".cmp");
+    std::vector<std::string> rows;
+    for (const std::string& line : FileLoader::loadRawLines(cmp.string())) {
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            rows.push_back(line);
+        }
+    }
+    size_t nextRow = 0;
+    auto takeRow = [&]() {
+        if (nextRow == rows.size()) {
+            throw std::runtime_error(cmp.string() + " has fewer rows than " + tstPath + " outputs");
+        }
+        return splitCells(rows[nextRow++]);
+    };
+
+    // Commands in script order; repeat blocks run their commands N times
+    std::regex ramAddress(R"(RAM\[(\d+)\])");
+    BatchStep step;
+    std::vector<uint16_t> addresses;
+    std::function<void(const std::vector<ScriptCommand>&)> apply = [&](const std::vector<ScriptCommand>& body) {
+        for (const ScriptCommand& command : body) {
+            const std::vector<std::string>& words = command.words;
+            const std::string& name = words[0];
+            std::smatch ram;
+            if (name == "load" || name == "output-file" || name == "compare-to") {
+                continue;
+            } else if (name == "set") {
+                if (words.size() != 3 || !std::regex_match(words[1], ram, ramAddress)) {
+                    throw std::runtime_error("Only \"set RAM[n] value\" is supported, not \"set " +
+                                             (words.size() > 1 ? words[1] : "") + "\" in " + tstPath);
+                }
+                // RAM set after cycles have run applies from then on
+                if (step.cycles > 0) {
+                    job.steps.push_back(step);
+                    step = BatchStep();
+                }
+                step.setRam.push_back({ static_cast<uint16_t>(std::stoul(ram[1])), static_cast<int16_t>(std::stoi(words[2])) });
+            } else if (name == "ticktock" && words.size() == 1) {
+                step.cycles++;
+            } else if (name == "repeat") {
+                uint64_t times = std::stoull(words[1]);
+                bool onlyTicks = std::all_of(command.body.begin(), command.body.end(), [](const ScriptCommand& inner) {
+                    return inner.words == std::vector<std::string>{ "ticktock" };
+                });
+                if (onlyTicks) {
+                    step.cycles += times * command.body.size();
+                } else {
+                    for (uint64_t i = 0; i < times; i++) {
+                        apply(command.body);
+                    }
+                }
+            } else if (name == "output-list") {
+                addresses.clear();
+                std::vector<std::string> names;
+                for (size_t i = 1; i < words.size(); i++) {
+                    std::string column = words[i].substr(0, words[i].find('%'));
+                    if (!std::regex_match(column, ram, ramAddress)) {
+                        throw std::runtime_error("Only RAM columns can be checked, not " + column + " in " + tstPath);
+                    }
+                    names.push_back(column);
+                    addresses.push_back(static_cast<uint16_t>(std::stoul(ram[1])));
+                }
+                // Header cells are cut to the column width, e.g. "RAM[3006"
+                std::vector<std::string> header = takeRow();
+                bool matches = header.size() == names.size();
+                for (size_t i = 0; matches && i < names.size(); i++) {
+                    matches = names[i].compare(0, header[i].size(), header[i]) == 0;
+                }
+                if (!matches) {
+                    throw std::runtime_error("Header " + std::to_string(nextRow) + " of " + cmp.string() +
+                                             " does not match the output-list");
+                }
+            } else if (name == "output" && words.size() == 1) {
+                if (addresses.empty()) {
+                    throw std::runtime_error("output before output-list in " + tstPath);
+                }
+                std::vector<std::string> expected = takeRow();
+                if (expected.size() != addresses.size()) {
+                    throw std::runtime_error("Column count of row " + std::to_string(nextRow) + " of " + cmp.string() +
+                                             " does not match the output-list");
+                }
+                for (size_t i = 0; i < addresses.size(); i++) {
+                    step.checks.push_back({ addresses[i], static_cast<int16_t>(std::stoi(expected[i])) });
+                }
+                job.steps.push_back(step);
+                step = BatchStep();
+            } else {
+                throw std::runtime_error("Unsupported command \"" + name + "\" in " + tstPath);
+            }
+        }
+    };
+    apply(block);
+
+    if (job.steps.empty()) {
+        throw std::runtime_error("No output in " + tstPath);
+    }
+    if (nextRow != rows.size()) {
+        throw std::runtime_error(cmp.string() + " has more rows than " + tstPath + " outputs");
+    }
+    return job;
+}
+
+std::vector<BatchJob> BatchRunner::discoverTestScripts(const std::string& dir) {
+    std::vector<fs::path> scripts;
+    for (const auto& entry : fs::recursive_directory_iterator(dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".tst") {
+            scripts.push_back(entry.path());
+        }
+    }
+    std::sort(scripts.begin(), scripts.end());
+
+    std::vector<BatchJob> jobs;
+    for (const fs::path& script : scripts) {
+        jobs.push_back(loadTestScript(script.string()));
+    }
+    return jobs;
+}
@@ -0,0 +1,299 @@
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/CInstructionTable.hpp"
+
+// --- Block Cache ---
+//
+// In ExecutionMode::BLOCK_CACHE, straight-line runs of ROM ending at the first
+// jumping C-instruction are translated on first execution into FusedOps and
+// cached by start PC. ROM cannot change after loadProgram(), so blocks are only
+// discarded when a new program is loaded.
+//
+// The fused ops cover the idioms VMCodeWriter emits for every push, pop and
+// stack adjustment, and leave A, D, PC and RAM exactly as the covered
+// instructions would. A fused op that would touch an illegal address replays
+// its instructions one at a time so the usual exception is raised.
+
+namespace {
+    // Raw encodings of the C-instructions the fused idioms are built from
+    const int16_t D_EQ_A    = static_cast<int16_t>(0b1110110000010000);
+    const int16_t D_EQ_M    = static_cast<int16_t>(0b1111110000010000);
+    const int16_t M_EQ_D    = static_cast<int16_t>(0b1110001100001000);
+    const int16_t A_EQ_M    = static_cast<int16_t>(0b1111110000100000);
+    const int16_t AM_EQ_M_1 = static_cast<int16_t>(0b1111110010101000);
+    const int16_t M_EQ_M_1  = static_cast<int16_t>(0b1111110010001000);
+    const int16_t M_EQ_M_P1 = static_cast<int16_t>(0b1111110111001000);
+    const int16_t AT_SP     = 0;
+
+    bool matches(const std::vector<int16_t>& rom, uint16_t pc, std::initializer_list<int16_t> pattern) {
+        // Patterns are only matched in the lower ROM image; mirrored PCs use single ops
+        if (pc + pattern.size() > rom.size()) {
+            return false;
+        }
+        for (int16_t word : pattern) {
+            if (rom[pc++] != word) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+void HackEmulator::clearBlockCache() {
+    block_lookup.assign(PC_SPACE, -1);
+    blocks.clear();
+    fused_ops.clear();
+}
+
+// --- Fused Op Handlers ---
+//
+// Each handler leaves PC just past the instructions its op covers. Under
+// StrictMemory, handlers that touch RAM through a computed address check it
+// first and fall back to executeFusedSlow() so the usual exception is raised.
+
+struct HackEmulator::BlockOps {
+    template <uint16_t Payload, typename Memory>
+    static void cOp(HackEmulator& emu, const FusedOp&) {
+        CInstructionTable::execute<Payload, Memory>(emu);
+    }
+
+    template <uint16_t Payload, typename Memory>
+    static void atCOp(HackEmulator& emu, const FusedOp& op) {
+        emu.a_register = op.value;
+        emu.program_counter = op.pc + 1;
+        if constexpr (CInstructionTable::isValidComp(Payload >> 6)) {
+            CInstructionTable::execute<Payload, Memory>(emu);
+        } else {
+            CInstructionTable::trap(emu);
+        }
+    }
+
+    static void cTrap(HackEmulator& emu, const FusedOp&) {
+        CInstructionTable::trap(emu);
+    }
+
+    template <uint16_t Payload, typename Memory>
+    static constexpr FusedHandler selectCOp() {
+        if constexpr (CInstructionTable::isValidComp(Payload >> 6)) { return &cOp<Payload, Memory>; }
+        else { return &cTrap; }
+    }
+
+    template <typename Memory, uint16_t... Payloads>
+    static constexpr std::array<FusedHandler, sizeof...(Payloads)> buildCOps(std::integer_sequence<uint16_t, Payloads...>) {
+        return { selectCOp<Payloads, Memory>()... };
+    }
+
+    template <typename Memory, uint16_t... Payloads>
+    static constexpr std::array<FusedHandler, sizeof...(Payloads)> buildAtCOps(std::integer_sequence<uint16_t, Payloads...>) {
+        return { &atCOp<Payloads, Memory>... };
+    }
+
+    static void loadA(HackEmulator& emu, const FusedOp& op) {
+        emu.a_register = op.value;
+        emu.program_counter = op.pc + 1;
+    }
+
+    static void loadDConst(HackEmulator& emu, const FusedOp& op) {
+        emu.a_register = op.value;
+        emu.d_register = op.value;
+        emu.program_counter = op.pc + 2;
+    }
+
+    template <typename Memory>
+    static void loadDMem(HackEmulator& emu, const FusedOp& op) {
+        if (Memory::checked && static_cast<uint16_t>(op.value) >= MEMORY_SIZE) { emu.executeFusedSlow(op); return; }
+        emu.a_register = op.value;
+        emu.d_register = emu.ram[Memory::index(op.value)];
+        emu.program_counter = op.pc + 2;
+    }
+
+    template <typename Memory>
+    static void storeD(HackEmulator& emu, const FusedOp& op) {
+        if (Memory::checked && static_cast<uint16_t>(op.value) >= MEMORY_SIZE) { emu.executeFusedSlow(op); return; }
+        emu.a_register = op.value;
+        emu.storeRam(Memory::index(op.value), emu.d_register);
+        emu.program_counter = op.pc + 2;
+    }
+
+    template <typename Memory>
+    static void popD(HackEmulator& emu, const FusedOp& op) {
+        int16_t sp = emu.ram[STACK_POINTER] - 1;
+        if (Memory::checked && static_cast<uint16_t>(sp) >= MEMORY_SIZE) { emu.executeFusedSlow(op); return; }
+        emu.storeRam(STACK_POINTER, sp);
+        emu.a_register = sp;
+        emu.d_register = emu.ram[Memory::index(sp)];
+        emu.program_counter = op.pc + op.length;
+    }
+
+    template <typename Memory>
+    static void pushD(HackEmulator& emu, const FusedOp& op) {
+        int16_t sp = emu.ram[STACK_POINTER];
+        // With SP pointing at itself the increment reads the pushed value back
+        if ((Memory::checked && static_cast<uint16_t>(sp) >= MEMORY_SIZE) || Memory::index(sp) == STACK_POINTER) {
+            emu.executeFusedSlow(op);
+            return;
+        }
+        emu.storeRam(Memory::index(sp), emu.d_register);
+        emu.storeRam(STACK_POINTER, sp + 1);
+        emu.a_register = STACK_POINTER;
+        emu.program_counter = op.pc + 5;
+    }
+
+    static void spInc(HackEmulator& emu, const FusedOp& op) {
+        emu.storeRam(STACK_POINTER, emu.ram[STACK_POINTER] + 1);
+        emu.a_register = STACK_POINTER;
+        emu.program_counter = op.pc + 2;
+    }
+
+    static void spDec(HackEmulator& emu, const FusedOp& op) {
+        emu.storeRam(STACK_POINTER, emu.ram[STACK_POINTER] - 1);
+        emu.a_register = STACK_POINTER;
+        emu.program_counter = op.pc + 2;
+    }
+
+    template <typename Memory>
+    struct Tables {
+        static const std::array<FusedHandler, 8192> cOps;
+        static const std::array<FusedHandler, 8192> atCOps;
+    };
+
+    // Picks the longest fused op starting at pc. Returns the number of instructions covered.
+    template <typename Memory>
+    static uint16_t fuse(const HackEmulator& emu, uint16_t pc, FusedOp& op) {
+        const std::vector<int16_t>& rom = emu.rom;
+        const std::vector<MicroOp>& ops = emu.predecoded_rom;
+        op = {};
+        op.pc = pc;
+        op.value = ops[pc].value;
+
+        if (matches(rom, pc, { AT_SP, A_EQ_M, M_EQ_D, AT_SP, M_EQ_M_P1 })) {
+            op.handler = &pushD<Memory>;
+            op.length = 5;
+        } else if (matches(rom, pc, { AT_SP, M_EQ_M_1, A_EQ_M, D_EQ_M })) {
+            op.handler = &popD<Memory>;
+            op.length = 4;
+        } else if (matches(rom, pc, { AT_SP, AM_EQ_M_1, D_EQ_M })) {
+            op.handler = &popD<Memory>;
+            op.length = 3;
+        } else if (matches(rom, pc, { AT_SP, M_EQ_M_P1 })) {
+            op.handler = &spInc;
+            op.length = 2;
+        } else if (matches(rom, pc, { AT_SP, M_EQ_M_1 })) {
+            op.handler = &spDec;
+            op.length = 2;
+        } else if (ops[pc].alu == AluOp::LOAD_A && pc + 1u < PC_SPACE && ops[pc + 1].alu != AluOp::LOAD_A) {
+            int16_t next = rom[(pc + 1) & (ROM_MAX_SIZE - 1)];
+            op.length = 2;
+            if (next == D_EQ_A) {
+                op.handler = &loadDConst;
+            } else if (next == D_EQ_M) {
+                op.handler = &loadDMem<Memory>;
+            } else if (next == M_EQ_D) {
+                op.handler = &storeD<Memory>;
+            } else {
+                op.handler = Tables<Memory>::atCOps[ops[pc + 1].value & 0x1FFF];
+            }
+        } else if (ops[pc].alu == AluOp::LOAD_A) {
+            op.handler = &loadA;
+            op.length = 1;
+        } else {
+            op.handler = Tables<Memory>::cOps[ops[pc].value & 0x1FFF];
+            op.length = 1;
+        }
+        return op.length;
+    }
+};
+
+template <typename Memory>
+const std::array<HackEmulator::FusedHandler, 8192> HackEmulator::BlockOps::Tables<Memory>::cOps =
+    HackEmulator::BlockOps::buildCOps<Memory>(std::make_integer_sequence<uint16_t, 8192>{});
+template <typename Memory>
+const std::array<HackEmulator::FusedHandler, 8192> HackEmulator::BlockOps::Tables<Memory>::atCOps =
+    HackEmulator::BlockOps::buildAtCOps<Memory>(std::make_integer_sequence<uint16_t, 8192>{});
+
+uint16_t HackEmulator::fuseAt(uint16_t pc, FusedOp& op) const {
+    if (memory_mode == MemoryMode::FAST) {
+        return BlockOps::fuse<FastMemory>(*this, pc, op);
+    }
+    return BlockOps::fuse<StrictMemory>(*this, pc, op);
+}
+
+const HackEmulator::TranslatedBlock& HackEmulator::blockAt(uint16_t pc) {
+    int32_t index = block_lookup[pc];
+    if (index >= 0) {
+        return blocks[index];
+    }
+
+    TranslatedBlock block = { static_cast<uint32_t>(fused_ops.size()), 0, 0 };
+    uint32_t addr = pc;
+    while (addr < PC_SPACE && block.length < MAX_BLOCK_LENGTH) {
+        FusedOp op;
+        uint16_t covered = fuseAt(static_cast<uint16_t>(addr), op);
+        if (block.length + covered > MAX_BLOCK_LENGTH && block.opCount > 0) {
+            break;
+        }
+        fused_ops.push_back(op);
+        block.opCount++;
+        block.length += covered;
+        addr += covered;
+
+        // A jumping C-instruction (always the last one an op covers) ends the block
+        const MicroOp& last = predecoded_rom[addr - 1];
+        if (last.alu != AluOp::LOAD_A && (last.control & (JUMP_GT | JUMP_EQ | JUMP_LT))) {
+            break;
+        }
+    }
+
+    block_lookup[pc] = static_cast<int32_t>(blocks.size());
+    blocks.push_back(block);
+    return blocks.back();
+}
+
+void HackEmulator::executeFusedSlow(const FusedOp& op) {
+    program_counter = op.pc;
+    for (uint8_t i = 0; i < op.length; i++) {
+        step();
+    }
+}
+
+void HackEmulator::executeBlock(const TranslatedBlock& block) {
+    const FusedOp* op = &fused_ops[block.firstOp];
+    const FusedOp* end = op + block.opCount;
+
+    for (; op != end; ++op) {
+        op->handler(*this, *op);
+    }
+}
+
+RunResult HackEmulator::runBlocks(uint64_t maxCycles, int32_t targetPC) {
+    uint64_t executed = 0;
+    while (executed < maxCycles) {
+        uint16_t pc = program_counter;
+        const TranslatedBlock& block = blockAt(pc);
+
+        // Single-step when the block does not fit the budget or would run past the breakpoint
+        bool breakpointInside = targetPC > pc && targetPC < pc + block.length;
+        uint32_t lastPC = pc;
+        if (block.length > maxCycles - executed || breakpointInside) {
+            step();
+            executed++;
+        } else {
+            executeBlock(block);
+            executed += block.length;
+            lastPC = pc + block.length - 1u;
+        }
+
+        if (program_counter == targetPC) {
+            cycle_count += executed;
+            return { executed, StopReason::BREAKPOINT, program_counter };
+        }
+        if (program_counter <= lastPC) {
+            if (checkHalt(targetPC)) {
+                cycle_count += executed;
+                return { executed, StopReason::HALTED, program_counter };
+            }
+            executed += checkLoop(targetPC, maxCycles - executed);
+        }
+    }
+    cycle_count += executed;
+    return { executed, StopReason::CYCLE_LIMIT, program_counter };
+}
@@ -0,0 +1,151 @@
+#include "Emulators/HackEmulator/ExecutionProfiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+    std::string trim(const std::string& str) {
+        const size_t first = str.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos) {
+            return "";
+        }
+        const size_t last = str.find_last_not_of(" \t\r\n");
+        return str.substr(first, last - first + 1);
+    }
+
+    double percent(uint64_t count, uint64_t total) {
+        return total == 0 ? 0.0 : 100.0 * count / total;
+    }
+
+    // Prints the largest entries of a name -> count map
+    void writeTotals(std::ostream& out, const std::string& title, const std::map<std::string, uint64_t>& totals,
+                     uint64_t total, size_t top) {
+        std::vector<std::pair<std::string, uint64_t>> sorted(totals.begin(), totals.end());
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+
+        out << "\n--- " << title << " ---\n";
+        for (size_t i = 0; i < sorted.size() && i < top; i++) {
+            out << std::right << std::setw(14) << sorted[i].second
+                << std::setw(8) << std::fixed << std::setprecision(2) << percent(sorted[i].second, total) << "% | "
+                << std::left << sorted[i].first << "\n";
+        }
+    }
+}
+
+ExecutionProfiler::ExecutionProfiler() {
+    reset();
+}
+
+void ExecutionProfiler::reset() {
+    executions.assign(ROM_SPACE, 0);
+    reads.assign(RAM_SPACE, 0);
+    writes.assign(RAM_SPACE, 0);
+}
+
+uint64_t ExecutionProfiler::getTotalExecutions() const {
+    return std::accumulate(executions.begin(), executions.end(), uint64_t(0));
+}
+
+// --- Listing Join ---
+//
+// ListingFileWriter rows are "ROM|Address| Source". Instructions carry their
+// ROM address, labels carry ROM[n] in the address column, and comments and
+// blank lines leave both columns empty.
+
+std::vector<ExecutionProfiler::ListingLine> ExecutionProfiler::loadListing(const std::string& listingPath) {
+    std::ifstream file(listingPath);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open listing file: " + listingPath);
+    }
+
+    std::vector<ListingLine> listing;
+    std::string label;
+    std::string comment;
+    std::string line;
+    std::getline(file, line); // Header
+
+    while (std::getline(file, line)) {
+        size_t first = line.find('|');
+        size_t second = first == std::string::npos ? std::string::npos : line.find('|', first + 1);
+        if (second == std::string::npos) {
+            continue;
+        }
+        std::string rom = trim(line.substr(0, first));
+        std::string address = trim(line.substr(first + 1, second - first - 1));
+        std::string source = trim(line.substr(second + 1));
+
+        if (rom.empty()) {
+            if (source.rfind("//", 0) == 0 && !trim(source.substr(2)).empty()) {
+                comment = trim(source.substr(2));
+            }
+        } else if (address.rfind("ROM[", 0) == 0) {
+            label = source.size() > 2 ? source.substr(1, source.size() - 2) : source;
+            comment.clear();
+        } else {
+            size_t index = std::stoul(rom);
+            if (index >= listing.size()) {
+                listing.resize(index + 1);
+            }
+            listing[index] = { source, label, comment };
+        }
+    }
+    return listing;
+}
+
+void ExecutionProfiler::writeReport(std::ostream& out, const std::string& listingPath, size_t top) const {
+    std::vector<ListingLine> listing = loadListing(listingPath);
+    uint64_t total = getTotalExecutions();
+
+    std::vector<uint16_t> hottest;
+    std::map<std::string, uint64_t> byLabel;
+    std::map<std::string, uint64_t> byComment;
+    for (uint32_t pc = 0; pc < ROM_SPACE; pc++) {
+        if (executions[pc] == 0) {
+            continue;
+        }
+        hottest.push_back(static_cast<uint16_t>(pc));
+        const ListingLine* entry = pc < listing.size() ? &listing[pc] : nullptr;
+        byLabel[entry && !entry->label.empty() ? entry->label : "(no label)"] += executions[pc];
+        byComment[entry && !entry->comment.empty() ? entry->comment : "(no comment)"] += executions[pc];
+    }
+    std::stable_sort(hottest.begin(), hottest.end(),
+                     [this](uint16_t lhs, uint16_t rhs) { return executions[lhs] > executions[rhs]; });
+
+    out << "Instructions executed: " << total << "\n";
+
+    out << "\n--- Hottest instructions ---\n";
+    for (size_t i = 0; i < hottest.size() && i < top; i++) {
+        uint16_t pc = hottest[i];
+        const ListingLine* entry = pc < listing.size() ? &listing[pc] : nullptr;
+        out << std::right << std::setw(6) << pc
+            << std::setw(14) << executions[pc]
+            << std::setw(8) << std::fixed << std::setprecision(2) << percent(executions[pc], total) << "% | "
+            << std::left << std::setw(24) << (entry ? entry->label : "") << " | "
+            << (entry ? entry->source : "") << "\n";
+    }
+
+    writeTotals(out, "By label", byLabel, total, top);
+    writeTotals(out, "By source comment", byComment, total, top);
+
+    std::vector<uint16_t> hotRam;
+    for (uint32_t addr = 0; addr < RAM_SPACE; addr++) {
+        if (reads[addr] + writes[addr] != 0) {
+            hotRam.push_back(static_cast<uint16_t>(addr));
+        }
+    }
+    std::stable_sort(hotRam.begin(), hotRam.end(), [this](uint16_t lhs, uint16_t rhs) {
+        return reads[lhs] + writes[lhs] > reads[rhs] + writes[rhs];
+    });
+
+    out << "\n--- Hottest RAM addresses (reads, writes) ---\n";
+    for (size_t i = 0; i < hotRam.size() && i < top; i++) {
+        uint16_t addr = hotRam[i];
+        out << std::right << std::setw(6) << addr
+            << std::setw(14) << reads[addr]
+            << std::setw(14) << writes[addr] << "\n";
+    }
+}
@@ -0,0 +1,132 @@
+#include "Emulators/HackEmulator/ExecutionTracer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+    const char TRACE_MAGIC[4] = { 'H', 'T', 'R', 'C' };
+    const size_t DRAIN_BATCH = 4096;
+
+    void putWord(std::vector<char>& bytes, uint16_t word) {
+        bytes.push_back(static_cast<char>(word & 0xFF));
+        bytes.push_back(static_cast<char>(word >> 8));
+    }
+
+    uint16_t getWord(const unsigned char* bytes) {
+        return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+    }
+}
+
+std::vector<TraceRecord> ExecutionTracer::drain() {
+    std::vector<TraceRecord> records(ring.capacity());
+    records.resize(ring.popBatch(records.data(), records.size()));
+    return records;
+}
+
+// --- Trace Writer ---
+
+TraceWriter::TraceWriter(ExecutionTracer& tracer, const std::string& path)
+    : tracer(tracer)
+{
+    // Checked before opening so a rejected tracer leaves an existing file alone
+    if (tracer.getOverflow() != TraceOverflow::WAIT) {
+        throw std::invalid_argument("TraceWriter needs a tracer created with TraceOverflow::WAIT");
+    }
+    out.open(path, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open trace file at " + path);
+    }
+    std::vector<char> header(TRACE_MAGIC, TRACE_MAGIC + 4);
+    putWord(header, VERSION);
+    putWord(header, RECORD_SIZE);
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    consumer = std::thread(&TraceWriter::consume, this);
+}
+
+TraceWriter::~TraceWriter() {
+    if (consumer.joinable()) {
+        stopping.store(true, std::memory_order_release);
+        consumer.join();
+    }
+}
+
+void TraceWriter::finish() {
+    if (consumer.joinable()) {
+        stopping.store(true, std::memory_order_release);
+        consumer.join();
+        out.flush();
+    }
+    if (error) {
+        std::exception_ptr pending = error;
+        error = nullptr;
+        std::rethrow_exception(pending);
+    }
+}
+
+void TraceWriter::consume() {
+    std::vector<TraceRecord> batch(DRAIN_BATCH);
+    std::vector<char> bytes;
+    while (true) {
+        // Read the flag first so a final drain after it sees every record
+        bool last = stopping.load(std::memory_order_acquire);
+        size_t count = tracer.drain(batch.data(), batch.size());
+        if (count > 0) {
+            writeBatch(batch.data(), count, bytes);
+        } else if (last) {
+            return;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+void TraceWriter::writeBatch(const TraceRecord* records, size_t count, std::vector<char>& bytes) {
+    if (error) {
+        // Keep draining after a failure so the emulator never blocks on a full buffer
+        return;
+    }
+    bytes.clear();
+    for (size_t i = 0; i < count; i++) {
+        const TraceRecord& record = records[i];
+        putWord(bytes, record.pc);
+        putWord(bytes, static_cast<uint16_t>(record.a_register));
+        putWord(bytes, static_cast<uint16_t>(record.d_register));
+        putWord(bytes, record.flags);
+        putWord(bytes, record.m_address);
+        putWord(bytes, static_cast<uint16_t>(record.m_value));
+    }
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+        error = std::make_exception_ptr(std::runtime_error("Failed writing the trace file"));
+        return;
+    }
+    records_written.fetch_add(count, std::memory_order_relaxed);
+}
+
+std::vector<TraceRecord> TraceWriter::readTrace(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Failed to open trace file: " + path);
+    }
+    unsigned char header[8];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        !std::equal(TRACE_MAGIC, TRACE_MAGIC + 4, header) ||
+        getWord(header + 4) != VERSION || getWord(header + 6) != RECORD_SIZE) {
+        throw std::runtime_error("Not a version 1 Hack trace file: " + path);
+    }
+
+    std::vector<TraceRecord> records;
+    unsigned char bytes[RECORD_SIZE];
+    while (in.read(reinterpret_cast<char*>(bytes), RECORD_SIZE)) {
+        records.push_back({
+            getWord(bytes),
+            static_cast<int16_t>(getWord(bytes + 2)),
+            static_cast<int16_t>(getWord(bytes + 4)),
+            getWord(bytes + 6),
+            getWord(bytes + 8),
+            static_cast<int16_t>(getWord(bytes + 10)),
+        });
+    }
+    return records;
+}
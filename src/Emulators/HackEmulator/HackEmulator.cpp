@@ -1,22 +1,97 @@
 #include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/CInstructionTable.hpp"
+#include "Emulators/HackEmulator/ExecutionProfiler.hpp"
+#include "Emulators/HackEmulator/ExecutionTracer.hpp"
+#include "Emulators/HackEmulator/KeyboardInput.hpp"
+#include "Emulators/HackEmulator/InstructionMix.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <atomic>
 
 // --- Constructor & Initialization ---
 
-HackEmulator::HackEmulator() : ram(MEMORY_SIZE, 0),
+HackEmulator::HackEmulator() : ram(RAM_SPACE, 0),
                                 a_register(0), 
                                 d_register(0), 
                                 program_counter(0)
 {
-
+    setMemoryMode(memory_mode);
+    written_rows.fill(1);
 }
 
 void HackEmulator::reset() {
     a_register = 0;
     d_register = 0;
     program_counter = 0;
-    ram.assign(MEMORY_SIZE, 0);
+    cycle_count = 0;
+    ram.assign(RAM_SPACE, 0);
+    dirty_pages.fill(0);
+    written_rows.fill(1);
+    synced_snapshot = 0;
+    accelerated_cycles = 0;
+    resetHaltProbe();
+}
+
+// --- Snapshots ---
+
+HackSnapshot HackEmulator::snapshot() {
+    static std::atomic<uint64_t> next_id{1};
+
+    HackSnapshot snap;
+    snap.id = next_id++;
+    snap.a_register = a_register;
+    snap.d_register = d_register;
+    snap.program_counter = program_counter;
+    snap.cycle_count = cycle_count;
+    snap.ram = ram;
+
+    dirty_pages.fill(0);
+    synced_snapshot = snap.id;
+    return snap;
+}
+
+void HackEmulator::restore(const HackSnapshot& snap) {
+    if (snap.ram.size() != RAM_SPACE) {
+        throw std::invalid_argument("Snapshot RAM size " + std::to_string(snap.ram.size()) + " does not match emulator RAM");
+    }
+
+    if (snap.id != 0 && snap.id == synced_snapshot) {
+        const uint16_t pageSize = 1 << PAGE_BITS;
+        for (uint16_t page = 0; page < PAGE_COUNT; page++) {
+            if (dirty_pages[page]) {
+                auto first = snap.ram.begin() + page * pageSize;
+                std::copy(first, first + pageSize, ram.begin() + page * pageSize);
+                std::fill_n(written_rows.begin() + (page << (PAGE_BITS - ROW_BITS)), 1 << (PAGE_BITS - ROW_BITS), 1);
+            }
+        }
+    } else {
+        std::copy(snap.ram.begin(), snap.ram.end(), ram.begin());
+        written_rows.fill(1);
+        synced_snapshot = snap.id;
+    }
+    dirty_pages.fill(0);
+
+    a_register = snap.a_register;
+    d_register = snap.d_register;
+    program_counter = snap.program_counter;
+    cycle_count = snap.cycle_count;
+    resetHaltProbe();
+}
+
+size_t HackEmulator::getDirtyPageCount() const {
+    return std::count(dirty_pages.begin(), dirty_pages.end(), 1);
+}
+
+// --- Screen ---
+
+void HackEmulator::takeDirtyScreenRows(std::vector<uint16_t>& rows) {
+    const uint16_t firstRow = SCREEN_BASE >> ROW_BITS;
+    for (uint16_t row = 0; row < SCREEN_ROWS; row++) {
+        if (written_rows[firstRow + row]) {
+            written_rows[firstRow + row] = 0;
+            rows.push_back(row);
+        }
+    }
 }
 
 // --- Program Loading ---
@@ -29,25 +104,192 @@ void HackEmulator::loadProgram(const std::vector<int16_t>& instructions) {
     std::copy(instructions.begin(), 
               instructions.end(), 
               rom.begin());
+
+    predecoded_rom.resize(PC_SPACE);
+    std::transform(rom.begin(), rom.end(), predecoded_rom.begin(), predecode);
+    std::copy(predecoded_rom.begin(), predecoded_rom.begin() + ROM_MAX_SIZE, predecoded_rom.begin() + ROM_MAX_SIZE);
+    clearBlockCache();
+    resetHaltProbe();
     program_counter = 0;
 }
 
-void HackEmulator::checkRamAddress(uint16_t addr) const {
-    if (addr >= MEMORY_SIZE) {
-        throw std::out_of_range("Illegal memory access at " + std::to_string(addr) + " on line " + std::to_string(program_counter) ); 
+void HackEmulator::throwIllegalAccess(uint16_t addr) const {
+    throw std::out_of_range("Illegal memory access at " + std::to_string(addr) + " on line " + std::to_string(program_counter) ); 
+}
+
+void HackEmulator::setMemoryMode(MemoryMode mode) {
+    memory_mode = mode;
+    c_handlers = mode == MemoryMode::FAST ? CInstructionTable::fastHandlers.data()
+                                          : CInstructionTable::strictHandlers.data();
+    // Translated blocks bake in the memory policy
+    if (!predecoded_rom.empty()) {
+        clearBlockCache();
+    }
+}
+
+// --- C-instruction Dispatch Table ---
+
+const std::array<HackEmulator::CInstructionTable::Handler, 8192> HackEmulator::CInstructionTable::strictHandlers =
+    HackEmulator::CInstructionTable::build<HackEmulator::StrictMemory>(std::make_integer_sequence<uint16_t, 8192>{});
+const std::array<HackEmulator::CInstructionTable::Handler, 8192> HackEmulator::CInstructionTable::fastHandlers =
+    HackEmulator::CInstructionTable::build<HackEmulator::FastMemory>(std::make_integer_sequence<uint16_t, 8192>{});
+
+inline void HackEmulator::execute(MicroOp op) {
+    if (op.alu == AluOp::LOAD_A) {
+        a_register = op.value;
+        program_counter++;
+        return;
     }
+    c_handlers[static_cast<uint16_t>(op.value)](*this);
 }
 
 // --- Execution Core ---
 
 void HackEmulator::executeNextInstruction() {
-    int16_t instruction = fetch();
-    DecodedInstruction decoded = decode(instruction);
-    execute(decoded);
+    execute(predecoded_rom[program_counter]);
+    cycle_count++;
+}
+
+void HackEmulator::step() {
+    execute(predecoded_rom[program_counter]);
+}
+
+template <bool Breakpoint, typename Observer>
+RunResult HackEmulator::interpret(uint64_t maxCycles, uint16_t targetPC, Observer& observer) {
+    const int32_t breakpoint = Breakpoint ? targetPC : -1;
+    const MicroOp* ops = predecoded_rom.data();
+    uint64_t executed = 0;
+    while (executed < maxCycles) {
+        uint16_t pc = program_counter;
+        const int16_t a = a_register;
+        if constexpr (Observer::enabled) {
+            observer.onInstruction(pc, ops[pc], a);
+        }
+        execute(ops[pc]);
+        if constexpr (Observer::enabled) {
+            observer.afterInstruction(pc, ops[pc], a, a_register, d_register, ram[static_cast<uint16_t>(a) & (RAM_SPACE - 1)],
+                                      program_counter);
+        }
+        executed++;
+        if (Breakpoint && program_counter == targetPC) {
+            cycle_count += executed;
+            return { executed, StopReason::BREAKPOINT, program_counter };
+        }
+        if (program_counter <= pc) {
+            if (checkHalt(breakpoint)) {
+                cycle_count += executed;
+                return { executed, StopReason::HALTED, program_counter };
+            }
+            if constexpr (!Observer::enabled) {
+                executed += checkLoop(breakpoint, maxCycles - executed);
+            }
+        }
+    }
+    cycle_count += executed;
+    return { executed, StopReason::CYCLE_LIMIT, program_counter };
+}
+
+RunResult HackEmulator::run(uint64_t maxCycles) {
+    return runWithKeyboard(maxCycles, [this](uint64_t cycles) {
+        if (execution_mode == ExecutionMode::BLOCK_CACHE) {
+            return runBlocks(cycles, -1);
+        }
+        NullObserver none;
+        return interpret<false>(cycles, 0, none);
+    });
+}
+
+RunResult HackEmulator::runUntil(uint16_t targetPC, uint64_t maxCycles) {
+    return runWithKeyboard(maxCycles, [this, targetPC](uint64_t cycles) {
+        if (execution_mode == ExecutionMode::BLOCK_CACHE) {
+            return runBlocks(cycles, targetPC);
+        }
+        NullObserver none;
+        return interpret<true>(cycles, targetPC, none);
+    });
 }
 
-int16_t HackEmulator::fetch() {
-    return rom[program_counter];
+RunResult HackEmulator::run(uint64_t maxCycles, ExecutionProfiler& profiler) {
+    return runWithKeyboard(maxCycles, [&](uint64_t cycles) { return interpret<false>(cycles, 0, profiler); });
+}
+
+RunResult HackEmulator::runUntil(uint16_t targetPC, uint64_t maxCycles, ExecutionProfiler& profiler) {
+    return runWithKeyboard(maxCycles, [&](uint64_t cycles) { return interpret<true>(cycles, targetPC, profiler); });
+}
+
+RunResult HackEmulator::run(uint64_t maxCycles, ExecutionTracer& tracer) {
+    return runWithKeyboard(maxCycles, [&](uint64_t cycles) { return interpret<false>(cycles, 0, tracer); });
+}
+
+RunResult HackEmulator::runUntil(uint16_t targetPC, uint64_t maxCycles, ExecutionTracer& tracer) {
+    return runWithKeyboard(maxCycles, [&](uint64_t cycles) { return interpret<true>(cycles, targetPC, tracer); });
+}
+
+RunResult HackEmulator::run(uint64_t maxCycles, InstructionMix& mix) {
+    return runWithKeyboard(maxCycles, [&](uint64_t cycles) { return interpret<false>(cycles, 0, mix); });
+}
+
+RunResult HackEmulator::runUntil(uint16_t targetPC, uint64_t maxCycles, InstructionMix& mix) {
+    return runWithKeyboard(maxCycles, [&](uint64_t cycles) { return interpret<true>(cycles, targetPC, mix); });
+}
+
+RunResult HackEmulator::runUntil(const std::function<bool(const HackEmulator&)>& predicate, uint64_t maxCycles) {
+    uint64_t executed = 0;
+    while (executed < maxCycles) {
+        if (keyboard_input) {
+            applyDueKeys();
+        }
+        execute(predecoded_rom[program_counter]);
+        executed++;
+        cycle_count++;
+        if (predicate(*this)) {
+            return { executed, StopReason::PREDICATE, program_counter };
+        }
+    }
+    return { executed, StopReason::CYCLE_LIMIT, program_counter };
+}
+
+// --- Keyboard ---
+
+void HackEmulator::pressKey(int16_t key) {
+    storeRam(KBD_ADDRESS, key);
+    if (keyboard_input) {
+        keyboard_input->record(cycle_count, key);
+    }
+}
+
+void HackEmulator::applyDueKeys() {
+    while (keyboard_input->hasPending() && keyboard_input->getNextCycle() <= cycle_count) {
+        pressKey(keyboard_input->takeNext().key);
+    }
+}
+
+template <typename Segment>
+RunResult HackEmulator::runWithKeyboard(uint64_t maxCycles, Segment runSegment) {
+    if (keyboard_input == nullptr) {
+        return runSegment(maxCycles);
+    }
+
+    uint64_t executed = 0;
+    while (true) {
+        applyDueKeys();
+        if (!keyboard_input->hasPending()) {
+            RunResult result = runSegment(maxCycles - executed);
+            result.cycles += executed;
+            return result;
+        }
+
+        const bool detectHalt = halt_detection;
+        halt_detection = false;
+        RunResult result = runSegment(std::min(maxCycles - executed, keyboard_input->getNextCycle() - cycle_count));
+        halt_detection = detectHalt;
+
+        executed += result.cycles;
+        if (result.reason != StopReason::CYCLE_LIMIT || executed == maxCycles) {
+            result.cycles = executed;
+            return result;
+        }
+    }
 }
 
 DecodedInstruction HackEmulator::decode(int16_t instruction) {
@@ -73,57 +315,40 @@ DecodedInstruction HackEmulator::decode(int16_t instruction) {
     return decoded;
 }
 
-void HackEmulator::execute(DecodedInstruction instruction) {
-    if (instruction.type == InstructionType::A_INSTRUCTION) {
-        a_register = instruction.addressOrValue;
-        program_counter++;
-    } else {
-        int16_t alu_input_A = instruction.is_M_bit ? getM() : a_register; 
-        
-        int16_t result = alu(instruction.is_M_bit, instruction.comp_code); 
-        uint16_t write_addr = a_register;
-
-        if (instruction.dest_D) { d_register = result; }
-        if (instruction.dest_A) { a_register = result; }
-        if (instruction.dest_M) { setRamValue(write_addr, result); }
-        
-        bool jump_condition_met = instruction.jump_JGT && result > 0;
-        jump_condition_met  = jump_condition_met || (instruction.jump_JEQ && result == 0);
-        jump_condition_met  = jump_condition_met || (instruction.jump_JLT && result < 0);
-        if (jump_condition_met) { program_counter = a_register; }
-        else { program_counter++; }
+MicroOp HackEmulator::predecode(int16_t instruction) {
+    MicroOp op = {};
+    if ((instruction & 0x8000) == 0) {
+        op.value = instruction & 0x7FFF;
+        op.alu = AluOp::LOAD_A;
+        return op;
     }
-}
 
-int16_t HackEmulator::alu(bool is_M_bit, uint8_t comp_code) {
-    int16_t d = d_register;
-    int16_t a_input = is_M_bit ? getM() : a_register;
-    int16_t result = 0;
-
-    switch (comp_code) {
-        case 0b101010: result = 0; break;
-        case 0b111111: result = 1; break;
-        case 0b111010: result = -1; break;
-        case 0b001100: result = d; break;
-        case 0b110000: result = a_input; break;
-        case 0b001101: result = ~d; break;
-        case 0b110001: result = ~a_input; break;
-        case 0b001111: result = -d; break;
-        case 0b110011: result = -a_input; break;
-        case 0b011111: result = d + 1; break;
-        case 0b110111: result = a_input + 1; break;
-        case 0b001110: result = d - 1; break;
-        case 0b110010: result = a_input - 1; break;
-        case 0b000010: result = d + a_input; break;
-        case 0b010011: result = d - a_input; break;
-        case 0b000111: result = a_input - d; break;
-        case 0b000000: result = d & a_input; break;
-        case 0b010101: result = d | a_input; break;
-        default:
-            throw std::runtime_error("Invalid ALU comp code: " + std::to_string(comp_code));
+    op.value = instruction & 0x1FFF;
+    op.control = instruction & 0x3F;
+
+    bool is_M_bit = (instruction >> 12) & 0x1;
+    switch ((instruction >> 6) & 0x3F) {
+        case 0b101010: op.alu = AluOp::ZERO; break;
+        case 0b111111: op.alu = AluOp::ONE; break;
+        case 0b111010: op.alu = AluOp::NEG_ONE; break;
+        case 0b001100: op.alu = AluOp::D; break;
+        case 0b110000: op.alu = is_M_bit ? AluOp::M : AluOp::A; break;
+        case 0b001101: op.alu = AluOp::NOT_D; break;
+        case 0b110001: op.alu = is_M_bit ? AluOp::NOT_M : AluOp::NOT_A; break;
+        case 0b001111: op.alu = AluOp::NEG_D; break;
+        case 0b110011: op.alu = is_M_bit ? AluOp::NEG_M : AluOp::NEG_A; break;
+        case 0b011111: op.alu = AluOp::D_PLUS_ONE; break;
+        case 0b110111: op.alu = is_M_bit ? AluOp::M_PLUS_ONE : AluOp::A_PLUS_ONE; break;
+        case 0b001110: op.alu = AluOp::D_MINUS_ONE; break;
+        case 0b110010: op.alu = is_M_bit ? AluOp::M_MINUS_ONE : AluOp::A_MINUS_ONE; break;
+        case 0b000010: op.alu = is_M_bit ? AluOp::D_PLUS_M : AluOp::D_PLUS_A; break;
+        case 0b010011: op.alu = is_M_bit ? AluOp::D_MINUS_M : AluOp::D_MINUS_A; break;
+        case 0b000111: op.alu = is_M_bit ? AluOp::M_MINUS_D : AluOp::A_MINUS_D; break;
+        case 0b000000: op.alu = is_M_bit ? AluOp::D_AND_M : AluOp::D_AND_A; break;
+        case 0b010101: op.alu = is_M_bit ? AluOp::D_OR_M : AluOp::D_OR_A; break;
+        default:       op.alu = AluOp::INVALID; break;
     }
-    
-    return result;
+    return op;
 }
 
 int16_t HackEmulator::peek(uint16_t addr) const {
@@ -158,7 +383,7 @@ int16_t HackEmulator::getThat(uint16_t offset) const {
 
 void HackEmulator::setRamValue(uint16_t addr, int16_t value) {
     checkRamAddress(addr);
-    ram[addr] = value;
+    storeRam(addr, value);
 }
 
 void HackEmulator::setARegister(int16_t value) {
@@ -0,0 +1,87 @@
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/HackAlu.hpp"
+#include <utility>
+
+// --- Halt Detection ---
+//
+// A probe runs the program forward on a private copy of A, D and PC, keeping
+// its RAM writes in a small overlay. If it comes back to the loop head with
+// A, D and every written word equal to the live state, the machine is back in
+// exactly the state it started the iteration in and will repeat it forever.
+// Probes never modify the emulator, so giving up costs only the probe itself.
+
+void HackEmulator::resetHaltProbe() {
+    halt_probe_interval = HALT_PROBE_FIRST;
+    halt_probe_countdown = HALT_PROBE_FIRST;
+}
+
+bool HackEmulator::probeHalt(int32_t targetPC) {
+    if (loopsForever(targetPC)) {
+        // Probe again at the next backward jump if the caller keeps running
+        halt_probe_countdown = 1;
+        return true;
+    }
+    if (halt_probe_interval < HALT_PROBE_MAX) {
+        halt_probe_interval *= 2;
+    }
+    halt_probe_countdown = halt_probe_interval;
+    return false;
+}
+
+bool HackEmulator::loopsForever(int32_t targetPC) const {
+    const uint16_t loopHead = program_counter;
+    int16_t a = a_register;
+    int16_t d = d_register;
+    uint16_t pc = program_counter;
+    std::vector<std::pair<uint16_t, int16_t>> writes;
+
+    auto read = [&](uint16_t addr) {
+        for (auto it = writes.rbegin(); it != writes.rend(); ++it) {
+            if (it->first == addr) {
+                return it->second;
+            }
+        }
+        return ram[addr];
+    };
+
+    for (uint32_t i = 0; i < HALT_PROBE_STEPS; i++) {
+        const MicroOp& op = predecoded_rom[pc];
+        if (op.alu == AluOp::LOAD_A) {
+            a = op.value;
+            pc++;
+        } else {
+            // Anything that would throw is left for the real run to report
+            uint16_t addr = static_cast<uint16_t>(a);
+            bool touchesM = aluReadsM(op.alu) || (op.control & DEST_M);
+            if (op.alu == AluOp::INVALID || (touchesM && addr >= MEMORY_SIZE)) {
+                return false;
+            }
+
+            int16_t result = aluCompute(op.value >> 6, d, aluReadsM(op.alu) ? read(addr) : a);
+            if (op.control & DEST_D) { d = result; }
+            if (op.control & DEST_A) { a = result; }
+            if (op.control & DEST_M) { writes.emplace_back(addr, result); }
+
+            bool taken = ((op.control & JUMP_GT) && result > 0) ||
+                         ((op.control & JUMP_EQ) && result == 0) ||
+                         ((op.control & JUMP_LT) && result < 0);
+            pc = taken ? static_cast<uint16_t>(a) : static_cast<uint16_t>(pc + 1);
+        }
+
+        if (pc == targetPC) {
+            return false;
+        }
+        if (pc == loopHead) {
+            if (a != a_register || d != d_register) {
+                return false;
+            }
+            for (const auto& write : writes) {
+                if (read(write.first) != ram[write.first]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,141 @@
+#include "Emulators/HackEmulator/InstructionMix.hpp"
+#include "Emulators/HackEmulator/ExecutionProfiler.hpp"
+#include <cctype>
+
+namespace {
+    void writeCounts(std::ostream& out, const std::map<std::string, uint64_t>& counts) {
+        out << "{";
+        bool first = true;
+        for (const auto& entry : counts) {
+            out << (first ? "" : ", ") << "\"" << entry.first << "\": " << entry.second;
+            first = false;
+        }
+        out << "}";
+    }
+}
+
+InstructionMix::InstructionMix() {
+    reset();
+}
+
+void InstructionMix::reset() {
+    executions.assign(ROM_SPACE, 0);
+    taken.assign(ROM_SPACE, 0);
+}
+
+// --- Mnemonics ---
+
+std::string InstructionMix::compMnemonic(AluOp op) {
+    switch (op) {
+        case AluOp::ZERO:        return "0";
+        case AluOp::ONE:         return "1";
+        case AluOp::NEG_ONE:     return "-1";
+        case AluOp::D:           return "D";
+        case AluOp::A:           return "A";
+        case AluOp::M:           return "M";
+        case AluOp::NOT_D:       return "!D";
+        case AluOp::NOT_A:       return "!A";
+        case AluOp::NOT_M:       return "!M";
+        case AluOp::NEG_D:       return "-D";
+        case AluOp::NEG_A:       return "-A";
+        case AluOp::NEG_M:       return "-M";
+        case AluOp::D_PLUS_ONE:  return "D+1";
+        case AluOp::A_PLUS_ONE:  return "A+1";
+        case AluOp::M_PLUS_ONE:  return "M+1";
+        case AluOp::D_MINUS_ONE: return "D-1";
+        case AluOp::A_MINUS_ONE: return "A-1";
+        case AluOp::M_MINUS_ONE: return "M-1";
+        case AluOp::D_PLUS_A:    return "D+A";
+        case AluOp::D_PLUS_M:    return "D+M";
+        case AluOp::D_MINUS_A:   return "D-A";
+        case AluOp::D_MINUS_M:   return "D-M";
+        case AluOp::A_MINUS_D:   return "A-D";
+        case AluOp::M_MINUS_D:   return "M-D";
+        case AluOp::D_AND_A:     return "D&A";
+        case AluOp::D_AND_M:     return "D&M";
+        case AluOp::D_OR_A:      return "D|A";
+        case AluOp::D_OR_M:      return "D|M";
+        default:                 return "invalid";
+    }
+}
+
+std::string InstructionMix::destMnemonic(uint8_t control) {
+    std::string dest;
+    if (control & HackEmulator::DEST_A) { dest += "A"; }
+    if (control & HackEmulator::DEST_M) { dest += "M"; }
+    if (control & HackEmulator::DEST_D) { dest += "D"; }
+    return dest.empty() ? "null" : dest;
+}
+
+std::string InstructionMix::jumpMnemonic(uint8_t control) {
+    static const char* const NAMES[8] = { "null", "JGT", "JEQ", "JGE", "JLT", "JNE", "JLE", "JMP" };
+    return NAMES[control & (HackEmulator::JUMP_GT | HackEmulator::JUMP_EQ | HackEmulator::JUMP_LT)];
+}
+
+// --- Summary ---
+
+InstructionMixSummary InstructionMix::summarize(const HackEmulator& emu, const std::string& listingPath) const {
+    std::vector<ExecutionProfiler::ListingLine> listing;
+    if (!listingPath.empty()) {
+        listing = ExecutionProfiler::loadListing(listingPath);
+    }
+
+    InstructionMixSummary summary;
+    for (uint32_t pc = 0; pc < ROM_SPACE; pc++) {
+        const uint64_t count = executions[pc];
+        if (count == 0) {
+            continue;
+        }
+        summary.instructions += count;
+
+        MicroOp op = emu.getMicroOp(static_cast<uint16_t>(pc));
+        if (op.alu == AluOp::LOAD_A) {
+            summary.a_instructions += count;
+            const std::string& source = pc < listing.size() ? listing[pc].source : std::string();
+            if (source.size() < 2 || source[0] != '@') {
+                summary.a_unclassified += count;
+            } else if (std::isdigit(static_cast<unsigned char>(source[1]))) {
+                summary.a_constants += count;
+            } else {
+                summary.a_symbols += count;
+            }
+            continue;
+        }
+
+        summary.c_instructions += count;
+        summary.comp[compMnemonic(op.alu)] += count;
+        summary.dest[destMnemonic(op.control)] += count;
+        const std::string jump = jumpMnemonic(op.control);
+        summary.jump[jump] += count;
+        if (jump == "null") {
+            continue;
+        }
+        summary.jump_taken[jump] += taken[pc];
+        if (jump != "JMP") {
+            summary.branches_taken += taken[pc];
+            summary.branches_not_taken += count - taken[pc];
+        }
+    }
+    return summary;
+}
+
+void InstructionMix::writeJson(std::ostream& out, const InstructionMixSummary& summary) {
+    out << "{\n"
+        << "  \"instructions\": " << summary.instructions << ",\n"
+        << "  \"a_instructions\": {\"total\": " << summary.a_instructions
+        << ", \"constant\": " << summary.a_constants
+        << ", \"symbol\": " << summary.a_symbols
+        << ", \"unclassified\": " << summary.a_unclassified << "},\n"
+        << "  \"c_instructions\": " << summary.c_instructions << ",\n"
+        << "  \"comp\": ";
+    writeCounts(out, summary.comp);
+    out << ",\n  \"dest\": ";
+    writeCounts(out, summary.dest);
+    out << ",\n  \"jump\": ";
+    writeCounts(out, summary.jump);
+    out << ",\n  \"jump_taken\": ";
+    writeCounts(out, summary.jump_taken);
+    out << ",\n  \"branches\": {\"taken\": " << summary.branches_taken
+        << ", \"not_taken\": " << summary.branches_not_taken << "}\n"
+        << "}";
+}
@@ -0,0 +1,60 @@
+#include "Emulators/HackEmulator/KeyboardInput.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+void KeyboardInput::schedule(uint64_t cycle, int16_t key) {
+    if (key < 0) {
+        throw std::invalid_argument("Invalid key code " + std::to_string(key));
+    }
+    auto position = std::upper_bound(pending.begin() + next, pending.end(), cycle,
+                                     [](uint64_t c, const KeyEvent& event) { return c < event.cycle; });
+    pending.insert(position, { cycle, key });
+}
+
+// --- Files ---
+
+void KeyboardInput::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open keyboard recording at " + path);
+    }
+    out << "# Hack keyboard events: <cycle> <key>\n";
+    for (const KeyEvent& event : recording) {
+        out << event.cycle << " " << event.key << "\n";
+    }
+    if (!out) {
+        throw std::runtime_error("Failed to write keyboard recording to " + path);
+    }
+}
+
+KeyboardInput KeyboardInput::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open keyboard recording: " + path);
+    }
+
+    KeyboardInput input;
+    std::string line;
+    size_t lineNumber = 0;
+    uint64_t lastCycle = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        uint64_t cycle;
+        int32_t key;
+        std::string extra;
+        if (!(fields >> cycle >> key) || (fields >> extra) || key < 0 || key > INT16_MAX || cycle < lastCycle) {
+            throw std::runtime_error("Invalid keyboard event on line " + std::to_string(lineNumber) + " of " + path);
+        }
+        input.pending.push_back({ cycle, static_cast<int16_t>(key) });
+        lastCycle = cycle;
+    }
+    return input;
+}
@@ -0,0 +1,226 @@
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+#include <limits>
+
+// --- Loop Acceleration ---
+//
+// A probe follows one iteration of the loop at the current PC twice. The first
+// pass runs on the live values and gives the state one iteration later. The
+// second pass runs with every value written as base + k * step, where step is
+// the change seen in the first pass, and checks that the iteration maps that
+// state to base + (k + 1) * step. If it does, then by induction every later
+// iteration does the same, for as long as each conditional jump on the path
+// sees a value with the same sign it had at k = 0. Addresses and computed jump
+// targets must not depend on k.
+
+namespace {
+    const uint64_t UNLIMITED = std::numeric_limits<uint64_t>::max();
+
+    // Iterations k >= 0 for which base + k * step keeps the sign it has at
+    // k = 0 without leaving the 16-bit range
+    uint64_t sameSignRun(int16_t base, int16_t step) {
+        const int32_t b = base;
+        const int32_t s = step;
+        if (s == 0) {
+            return UNLIMITED;
+        }
+        if (b == 0) {
+            return 1;
+        }
+        if (b > 0) {
+            return s < 0 ? (b - 1) / -s + 1 : (32767 - b) / s + 1;
+        }
+        return s > 0 ? (-b - 1) / s + 1 : (b + 32768) / -s + 1;
+    }
+
+    int16_t advance(int16_t base, int16_t step, uint64_t iterations) {
+        return static_cast<int16_t>(static_cast<uint16_t>(base) + iterations * static_cast<uint16_t>(step));
+    }
+}
+
+void HackEmulator::setLoopAcceleration(bool enabled) {
+    loop_acceleration = enabled;
+    loop_probe_interval = LOOP_PROBE_FIRST;
+    loop_probe_countdown = LOOP_PROBE_FIRST;
+}
+
+// The ALU on values of the form base + k * step. Base and step are computed
+// separately, which is exact for the linear ops; NOT is -1 - x, so it negates
+// the step. AND and OR are not linear and only accept values with step 0.
+bool HackEmulator::evaluateLoop(AluOp op, LoopValue a, LoopValue d, LoopValue m, LoopValue& r) {
+    auto make = [&](int base, int step) {
+        r = { static_cast<int16_t>(base), static_cast<int16_t>(step) };
+        return true;
+    };
+    switch (op) {
+        case AluOp::ZERO:        return make(0, 0);
+        case AluOp::ONE:         return make(1, 0);
+        case AluOp::NEG_ONE:     return make(-1, 0);
+        case AluOp::D:           return make(d.base, d.step);
+        case AluOp::A:           return make(a.base, a.step);
+        case AluOp::M:           return make(m.base, m.step);
+        case AluOp::NOT_D:       return make(~d.base, -d.step);
+        case AluOp::NOT_A:       return make(~a.base, -a.step);
+        case AluOp::NOT_M:       return make(~m.base, -m.step);
+        case AluOp::NEG_D:       return make(-d.base, -d.step);
+        case AluOp::NEG_A:       return make(-a.base, -a.step);
+        case AluOp::NEG_M:       return make(-m.base, -m.step);
+        case AluOp::D_PLUS_ONE:  return make(d.base + 1, d.step);
+        case AluOp::A_PLUS_ONE:  return make(a.base + 1, a.step);
+        case AluOp::M_PLUS_ONE:  return make(m.base + 1, m.step);
+        case AluOp::D_MINUS_ONE: return make(d.base - 1, d.step);
+        case AluOp::A_MINUS_ONE: return make(a.base - 1, a.step);
+        case AluOp::M_MINUS_ONE: return make(m.base - 1, m.step);
+        case AluOp::D_PLUS_A:    return make(d.base + a.base, d.step + a.step);
+        case AluOp::D_PLUS_M:    return make(d.base + m.base, d.step + m.step);
+        case AluOp::D_MINUS_A:   return make(d.base - a.base, d.step - a.step);
+        case AluOp::D_MINUS_M:   return make(d.base - m.base, d.step - m.step);
+        case AluOp::A_MINUS_D:   return make(a.base - d.base, a.step - d.step);
+        case AluOp::M_MINUS_D:   return make(m.base - d.base, m.step - d.step);
+        case AluOp::D_AND_A:     return d.step == 0 && a.step == 0 && make(d.base & a.base, 0);
+        case AluOp::D_AND_M:     return d.step == 0 && m.step == 0 && make(d.base & m.base, 0);
+        case AluOp::D_OR_A:      return d.step == 0 && a.step == 0 && make(d.base | a.base, 0);
+        case AluOp::D_OR_M:      return d.step == 0 && m.step == 0 && make(d.base | m.base, 0);
+        default:                 return false;
+    }
+}
+
+bool HackEmulator::followIteration(int32_t targetPC, const LoopState& start, LoopState& end) const {
+    const uint16_t loopHead = program_counter;
+    LoopValue a = start.a;
+    LoopValue d = start.d;
+    uint16_t pc = program_counter;
+    end.words.clear();
+    end.iterations = UNLIMITED;
+
+    auto read = [&](uint16_t addr) {
+        for (auto it = end.words.rbegin(); it != end.words.rend(); ++it) {
+            if (it->first == addr) {
+                return it->second;
+            }
+        }
+        for (const auto& word : start.words) {
+            if (word.first == addr) {
+                return word.second;
+            }
+        }
+        return LoopValue{ ram[addr], 0 };
+    };
+
+    for (uint32_t i = 1; i <= HALT_PROBE_STEPS; i++) {
+        const MicroOp& op = predecoded_rom[pc];
+        if (op.alu == AluOp::LOAD_A) {
+            a = { op.value, 0 };
+            pc++;
+        } else {
+            // Anything that would throw is left for the real run to report
+            uint16_t addr = static_cast<uint16_t>(a.base);
+            bool touchesM = aluReadsM(op.alu) || (op.control & DEST_M);
+            if (touchesM && (a.step != 0 || addr >= MEMORY_SIZE)) {
+                return false;
+            }
+
+            LoopValue result;
+            if (!evaluateLoop(op.alu, a, d, aluReadsM(op.alu) ? read(addr) : LoopValue{ 0, 0 }, result)) {
+                return false;
+            }
+            if (op.control & DEST_M) {
+                bool found = false;
+                for (auto& word : end.words) {
+                    if (word.first == addr) {
+                        word.second = result;
+                        found = true;
+                    }
+                }
+                if (!found) {
+                    end.words.emplace_back(addr, result);
+                }
+            }
+            if (op.control & DEST_D) { d = result; }
+            if (op.control & DEST_A) { a = result; }
+
+            const uint8_t jump = op.control & (JUMP_GT | JUMP_EQ | JUMP_LT);
+            bool taken = ((jump & JUMP_GT) && result.base > 0) ||
+                         ((jump & JUMP_EQ) && result.base == 0) ||
+                         ((jump & JUMP_LT) && result.base < 0);
+            if (jump != 0 && jump != (JUMP_GT | JUMP_EQ | JUMP_LT)) {
+                end.iterations = std::min(end.iterations, sameSignRun(result.base, result.step));
+            }
+            if (taken && a.step != 0) {
+                return false;
+            }
+            pc = taken ? static_cast<uint16_t>(a.base) : static_cast<uint16_t>(pc + 1);
+        }
+
+        if (pc == targetPC) {
+            return false;
+        }
+        if (pc == loopHead) {
+            end.a = a;
+            end.d = d;
+            end.length = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t HackEmulator::probeLoop(int32_t targetPC, uint64_t budget) {
+    auto giveUp = [this]() -> uint64_t {
+        if (loop_probe_interval < LOOP_PROBE_MAX) {
+            loop_probe_interval *= 2;
+        }
+        loop_probe_countdown = loop_probe_interval;
+        return 0;
+    };
+
+    // The live values, giving the step of everything the iteration changes
+    LoopState live;
+    live.a = { a_register, 0 };
+    live.d = { d_register, 0 };
+    LoopState once;
+    if (!followIteration(targetPC, live, once)) {
+        return giveUp();
+    }
+
+    LoopState start;
+    start.a = { a_register, static_cast<int16_t>(once.a.base - a_register) };
+    start.d = { d_register, static_cast<int16_t>(once.d.base - d_register) };
+    bool changes = start.a.step != 0 || start.d.step != 0;
+    for (const auto& word : once.words) {
+        int16_t value = ram[word.first];
+        start.words.emplace_back(word.first, LoopValue{ value, static_cast<int16_t>(word.second.base - value) });
+        changes = changes || value != word.second.base;
+    }
+    // A loop that changes nothing is halt detection's to report
+    if (!changes && halt_detection) {
+        return giveUp();
+    }
+
+    LoopState next;
+    if (!followIteration(targetPC, start, next)) {
+        return giveUp();
+    }
+    auto inductive = [](LoopValue before, LoopValue after) {
+        return after.step == before.step && after.base == static_cast<int16_t>(before.base + before.step);
+    };
+    bool holds = inductive(start.a, next.a) && inductive(start.d, next.d) && next.words.size() == start.words.size();
+    for (size_t i = 0; holds && i < start.words.size(); i++) {
+        holds = next.words[i].first == start.words[i].first && inductive(start.words[i].second, next.words[i].second);
+    }
+    uint64_t iterations = std::min(next.iterations, budget / next.length);
+    if (!holds || iterations < 2) {
+        return giveUp();
+    }
+
+    a_register = advance(start.a.base, start.a.step, iterations);
+    d_register = advance(start.d.base, start.d.step, iterations);
+    for (const auto& word : start.words) {
+        storeRam(word.first, advance(word.second.base, word.second.step, iterations));
+    }
+    loop_probe_interval = LOOP_PROBE_FIRST;
+    loop_probe_countdown = LOOP_PROBE_FIRST;
+
+    uint64_t skipped = iterations * next.length;
+    accelerated_cycles += skipped;
+    return skipped;
+}
@@ -0,0 +1,290 @@
+#include "Emulators/HackEmulator/NativeTranslator.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    const uint16_t JUMP_BITS = 0b000111;
+    const uint16_t DEST_A = 0b100000;
+    const uint16_t DEST_D = 0b010000;
+    const uint16_t DEST_M = 0b001000;
+    const char* M_OPERAND = "ram[static_cast<uint16_t>(a) & 0x7FFF]";
+
+    bool isAInstruction(int16_t instruction) {
+        return instruction >= 0;
+    }
+
+    std::string jumpCondition(uint16_t jump) {
+        switch (jump) {
+            case 0b001: return "r > 0";
+            case 0b010: return "r == 0";
+            case 0b011: return "r >= 0";
+            case 0b100: return "r < 0";
+            case 0b101: return "r != 0";
+            case 0b110: return "r <= 0";
+            default: return "true";
+        }
+    }
+}
+
+NativeTranslator::NativeTranslator(const std::vector<int16_t>& rom, const std::string& functionName)
+    : rom(rom), functionName(functionName)
+{
+    if (rom.size() > 32768) {
+        throw std::runtime_error("Program size exceeds maximum Hack ROM capacity (32768 instructions).");
+    }
+    findLeaders();
+}
+
+bool NativeTranslator::isJump(int16_t instruction) {
+    return !isAInstruction(instruction) && (instruction & JUMP_BITS) != 0;
+}
+
+// --- Basic Blocks ---
+// A block starts at 0, after every jump and at every static jump target.
+
+void NativeTranslator::findLeaders() {
+    is_leader.assign(rom.size(), false);
+    if (!rom.empty()) {
+        is_leader[0] = true;
+    }
+    for (uint16_t pc = 0; pc < rom.size(); pc++) {
+        if (!isJump(rom[pc])) {
+            continue;
+        }
+        if (pc + 1u < rom.size()) {
+            is_leader[pc + 1] = true;
+        }
+        uint16_t target;
+        if (staticTarget(pc, target) && target < rom.size()) {
+            is_leader[target] = true;
+        }
+    }
+    // The scan above can turn a jump into a leader after using its @X, which
+    // only adds a spare block boundary
+    leaders.clear();
+    for (uint16_t pc = 0; pc < rom.size(); pc++) {
+        if (is_leader[pc]) {
+            leaders.push_back(pc);
+        }
+    }
+}
+
+// A jump is static when the @X right before it is in the same block and the
+// jump does not overwrite A
+bool NativeTranslator::staticTarget(uint16_t pc, uint16_t& target) const {
+    if (pc == 0 || is_leader[pc] || !isAInstruction(rom[pc - 1]) || (rom[pc] & DEST_A)) {
+        return false;
+    }
+    target = static_cast<uint16_t>(rom[pc - 1]);
+    return true;
+}
+
+bool NativeTranslator::isHaltLoop(uint16_t leader, uint16_t end) const {
+    if (end != leader + 2 || rom[leader] != static_cast<int16_t>(leader)) {
+        return false;
+    }
+    int16_t jump = rom[leader + 1];
+    return !isAInstruction(jump) && (jump & JUMP_BITS) == JUMP_BITS && (jump & (DEST_A | DEST_D | DEST_M)) == 0 &&
+           !compExpression((jump >> 6) & 0x7F).empty();
+}
+
+// Empty for comp codes the Hack ALU does not define
+std::string NativeTranslator::compExpression(uint16_t comp) {
+    std::string y = (comp & 0x40) ? M_OPERAND : "a";
+    switch (comp & 0x3F) {
+        case 0b101010: return "0";
+        case 0b111111: return "1";
+        case 0b111010: return "-1";
+        case 0b001100: return "d";
+        case 0b001101: return "~d";
+        case 0b001111: return "-d";
+        case 0b011111: return "d + 1";
+        case 0b001110: return "d - 1";
+        case 0b110000: return y;
+        case 0b110001: return "~" + y;
+        case 0b110011: return "-" + y;
+        case 0b110111: return y + " + 1";
+        case 0b110010: return y + " - 1";
+        case 0b000010: return "d + " + y;
+        case 0b010011: return "d - " + y;
+        case 0b000111: return y + " - d";
+        case 0b000000: return "d & " + y;
+        case 0b010101: return "d | " + y;
+        default: return "";
+    }
+}
+
+// --- Code Generation ---
+
+void NativeTranslator::write(std::ostream& out) const {
+    out << "// Generated by HackEmulator_aot. Do not edit.\n"
+        << "#include <cstdint>\n"
+        << "#include <stdexcept>\n"
+        << "#include <string>\n\n"
+        << "namespace {\n\n";
+
+    out << "const uint16_t ROM_SIZE = " << rom.size() << ";\n"
+        << "const int16_t ROM[" << std::max<size_t>(rom.size(), 1) << "] = {";
+    for (size_t i = 0; i < rom.size(); i++) {
+        out << (i % 16 == 0 ? "\n    " : " ") << rom[i] << ",";
+    }
+    out << (rom.empty() ? " 0 };\n\n" : "\n};\n\n");
+    writeStep(out);
+    out << "} // namespace\n\n";
+
+    out << "uint64_t " << functionName
+        << "(int16_t* ram, int16_t& a_reg, int16_t& d_reg, uint16_t& pc_reg, uint64_t maxCycles) {\n"
+        << "    int16_t a = a_reg;\n"
+        << "    int16_t d = d_reg;\n"
+        << "    uint16_t pc = pc_reg;\n"
+        << "    uint64_t cycles = 0;\n"
+        << "    int16_t r;\n"
+        << "    (void)r;\n\n";
+
+    out << "dispatch:\n"
+        << "    switch (pc) {\n";
+    for (uint16_t leader : leaders) {
+        out << "        case " << leader << ": goto B_" << leader << ";\n";
+    }
+    out << "        default: goto slow;\n"
+        << "    }\n\n";
+
+    for (size_t i = 0; i < leaders.size(); i++) {
+        uint16_t end = i + 1 < leaders.size() ? leaders[i + 1] : static_cast<uint16_t>(rom.size());
+        writeBlock(out, leaders[i], end);
+    }
+
+    out << "slow:\n"
+        << "    if (cycles == maxCycles) goto done;\n"
+        << "    if (!step(ram, a, d, pc)) {\n"
+        << "        a_reg = a; d_reg = d; pc_reg = pc;\n"
+        << "        throw invalidComp(pc);\n"
+        << "    }\n"
+        << "    cycles++;\n"
+        << "    goto dispatch;\n\n"
+        << "done:\n"
+        << "    a_reg = a;\n"
+        << "    d_reg = d;\n"
+        << "    pc_reg = pc;\n"
+        << "    return cycles;\n"
+        << "}\n";
+}
+
+// One instruction at a time, for budget tails and PCs outside the blocks
+void NativeTranslator::writeStep(std::ostream& out) const {
+    out << "std::runtime_error invalidComp(uint16_t pc) {\n"
+        << "    int16_t instruction = ROM[pc & 0x7FFF];\n"
+        << "    return std::runtime_error(\"Invalid ALU comp code: \" + std::to_string((instruction >> 6) & 0x3F));\n"
+        << "}\n\n"
+        << "bool step(int16_t* ram, int16_t& a, int16_t& d, uint16_t& pc) {\n"
+        << "    uint16_t index = pc & 0x7FFF;\n"
+        << "    int16_t instruction = index < ROM_SIZE ? ROM[index] : 0;\n"
+        << "    if (instruction >= 0) {\n"
+        << "        a = instruction;\n"
+        << "        pc++;\n"
+        << "        return true;\n"
+        << "    }\n"
+        << "    uint16_t address = static_cast<uint16_t>(a) & 0x7FFF;\n"
+        << "    int y = (instruction & 0x1000) ? ram[address] : a;\n"
+        << "    int x;\n"
+        << "    switch ((instruction >> 6) & 0x3F) {\n"
+        << "        case 0b101010: x = 0; break;\n"
+        << "        case 0b111111: x = 1; break;\n"
+        << "        case 0b111010: x = -1; break;\n"
+        << "        case 0b001100: x = d; break;\n"
+        << "        case 0b001101: x = ~d; break;\n"
+        << "        case 0b001111: x = -d; break;\n"
+        << "        case 0b011111: x = d + 1; break;\n"
+        << "        case 0b001110: x = d - 1; break;\n"
+        << "        case 0b110000: x = y; break;\n"
+        << "        case 0b110001: x = ~y; break;\n"
+        << "        case 0b110011: x = -y; break;\n"
+        << "        case 0b110111: x = y + 1; break;\n"
+        << "        case 0b110010: x = y - 1; break;\n"
+        << "        case 0b000010: x = d + y; break;\n"
+        << "        case 0b010011: x = d - y; break;\n"
+        << "        case 0b000111: x = y - d; break;\n"
+        << "        case 0b000000: x = d & y; break;\n"
+        << "        case 0b010101: x = d | y; break;\n"
+        << "        default: return false;\n"
+        << "    }\n"
+        << "    int16_t r = static_cast<int16_t>(x);\n"
+        << "    if (instruction & " << DEST_M << ") ram[address] = r;\n"
+        << "    if (instruction & " << DEST_D << ") d = r;\n"
+        << "    if (instruction & " << DEST_A << ") a = r;\n"
+        << "    bool taken = ((instruction & 1) && r > 0) || ((instruction & 2) && r == 0) || ((instruction & 4) && r < 0);\n"
+        << "    pc = taken ? static_cast<uint16_t>(a) : static_cast<uint16_t>(pc + 1);\n"
+        << "    return true;\n"
+        << "}\n\n";
+}
+
+void NativeTranslator::writeBlock(std::ostream& out, uint16_t leader, uint16_t end) const {
+    uint16_t length = end - leader;
+    out << "B_" << leader << ":\n";
+
+    if (isHaltLoop(leader, end)) {
+        // Nothing changes on later passes, so the rest of the budget ends on
+        // @X or on the jump depending on parity
+        out << "    if (cycles == maxCycles) { pc = " << leader << "; goto done; }\n"
+            << "    a = " << leader << ";\n"
+            << "    pc = ((maxCycles - cycles) & 1) ? " << leader + 1 << " : " << leader << ";\n"
+            << "    cycles = maxCycles;\n"
+            << "    goto done;\n\n";
+        return;
+    }
+
+    out << "    if (maxCycles - cycles < " << length << ") { pc = " << leader << "; goto slow; }\n"
+        << "    cycles += " << length << ";\n";
+    for (uint16_t pc = leader; pc < end; pc++) {
+        writeInstruction(out, pc, pc + 1 == end, end);
+    }
+    out << "\n";
+}
+
+void NativeTranslator::writeInstruction(std::ostream& out, uint16_t pc, bool last, uint16_t end) const {
+    int16_t instruction = rom[pc];
+    if (isAInstruction(instruction)) {
+        out << "    a = " << instruction << ";\n";
+    } else {
+        uint16_t comp = (instruction >> 6) & 0x7F;
+        std::string expression = compExpression(comp);
+        if (expression.empty()) {
+            out << "    a_reg = a; d_reg = d; pc_reg = " << pc << ";\n"
+                << "    throw invalidComp(" << pc << ");\n";
+            return;
+        }
+
+        uint16_t dest = instruction & (DEST_A | DEST_D | DEST_M);
+        uint16_t jump = instruction & JUMP_BITS;
+        if (dest != 0 || jump != 0) {
+            out << "    r = static_cast<int16_t>(" << expression << ");\n";
+        }
+        // M is written at the A the instruction started with
+        if (dest & DEST_M) { out << "    " << M_OPERAND << " = r;\n"; }
+        if (dest & DEST_D) { out << "    d = r;\n"; }
+        if (dest & DEST_A) { out << "    a = r;\n"; }
+
+        if (jump != 0) {
+            uint16_t target;
+            std::string jumpTo;
+            if (staticTarget(pc, target) && target < rom.size()) {
+                jumpTo = "goto B_" + std::to_string(target) + ";";
+            } else if (staticTarget(pc, target)) {
+                jumpTo = "{ pc = " + std::to_string(target) + "; goto dispatch; }";
+            } else {
+                jumpTo = "{ pc = static_cast<uint16_t>(a); goto dispatch; }";
+            }
+            if (jump == JUMP_BITS) {
+                out << "    " << jumpTo << "\n";
+                return;
+            }
+            out << "    if (" << jumpCondition(jump) << ") " << jumpTo << "\n";
+        }
+    }
+
+    // The next block follows in the output, except after the last instruction
+    if (last && end == rom.size()) {
+        out << "    pc = " << end << ";\n"
+            << "    goto dispatch;\n";
+    }
+}
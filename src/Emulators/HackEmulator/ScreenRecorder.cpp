@@ -0,0 +1,120 @@
+#include "Emulators/HackEmulator/ScreenRecorder.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+ScreenRecorder::ScreenRecorder(const std::string& outputDir, FrameFormat format, uint64_t cyclesPerFrame)
+    : outputDir(outputDir), format(format), cyclesPerFrame(cyclesPerFrame)
+{
+    if (cyclesPerFrame == 0) {
+        throw std::invalid_argument("ScreenRecorder needs a positive cycles-per-frame interval");
+    }
+    fs::path outPath(outputDir);
+    if (!fs::exists(outPath)) {
+        fs::create_directories(outPath);
+    }
+
+    std::string header;
+    switch (format) {
+        case FrameFormat::PBM:
+            header = "P4\n512 256\n";
+            rowSize = SCREEN_WIDTH / 8;
+            break;
+        case FrameFormat::PPM:
+            header = "P6\n512 256\n255\n";
+            rowSize = SCREEN_WIDTH * 3;
+            break;
+        case FrameFormat::RAW:
+            rowSize = HackEmulator::SCREEN_ROW_WORDS * 2;
+            break;
+    }
+    headerSize = header.size();
+    frame.assign(headerSize + rowSize * HackEmulator::SCREEN_ROWS, 0);
+    std::copy(header.begin(), header.end(), frame.begin());
+}
+
+RunResult ScreenRecorder::run(HackEmulator& emu, uint64_t maxCycles) {
+    RunResult total = { 0, StopReason::CYCLE_LIMIT, emu.getPC() };
+    while (total.cycles < maxCycles) {
+        RunResult slice = emu.run(std::min(cyclesPerFrame, maxCycles - total.cycles));
+        total.cycles += slice.cycles;
+        total.reason = slice.reason;
+        total.pc = slice.pc;
+        captureFrame(emu);
+        if (slice.reason == StopReason::HALTED) {
+            break;
+        }
+    }
+    return total;
+}
+
+// Hack stores the leftmost pixel of each word in bit 0
+void ScreenRecorder::encodeRow(const int16_t* words, uint8_t* out) const {
+    for (uint16_t w = 0; w < HackEmulator::SCREEN_ROW_WORDS; w++) {
+        uint16_t word = static_cast<uint16_t>(words[w]);
+        switch (format) {
+            case FrameFormat::PBM:
+                // PBM packs pixels MSB first, so each byte is bit-reversed
+                for (int half = 0; half < 2; half++) {
+                    uint8_t bits = static_cast<uint8_t>(word >> (half * 8));
+                    uint8_t reversed = 0;
+                    for (int i = 0; i < 8; i++) {
+                        reversed = static_cast<uint8_t>((reversed << 1) | ((bits >> i) & 1));
+                    }
+                    out[w * 2 + half] = reversed;
+                }
+                break;
+            case FrameFormat::PPM:
+                for (int i = 0; i < 16; i++) {
+                    uint8_t shade = ((word >> i) & 1) ? 0 : 255;
+                    uint8_t* pixel = out + (w * 16 + i) * 3;
+                    pixel[0] = pixel[1] = pixel[2] = shade;
+                }
+                break;
+            case FrameFormat::RAW:
+                out[w * 2] = static_cast<uint8_t>(word & 0xFF);
+                out[w * 2 + 1] = static_cast<uint8_t>(word >> 8);
+                break;
+        }
+    }
+}
+
+void ScreenRecorder::captureFrame(HackEmulator& emu) {
+    dirtyRows.clear();
+    emu.takeDirtyScreenRows(dirtyRows);
+    if (frameCount == 0) {
+        // Nothing is encoded yet, so the first frame covers every row
+        dirtyRows.resize(HackEmulator::SCREEN_ROWS);
+        for (uint16_t row = 0; row < HackEmulator::SCREEN_ROWS; row++) {
+            dirtyRows[row] = row;
+        }
+    }
+    for (uint16_t row : dirtyRows) {
+        encodeRow(emu.getScreenRow(row), frame.data() + headerSize + row * rowSize);
+    }
+    lastDirtyRows = dirtyRows.size();
+
+    std::string path = framePath(frameCount);
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open frame file at " + path);
+    }
+    out.write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Could not write frame file at " + path);
+    }
+    frameCount++;
+}
+
+std::string ScreenRecorder::framePath(size_t index) const {
+    const char* extension = format == FrameFormat::PBM ? ".pbm" : format == FrameFormat::PPM ? ".ppm" : ".raw";
+    std::ostringstream name;
+    name << "frame_" << std::setw(6) << std::setfill('0') << index << extension;
+    return (fs::path(outputDir) / name.str()).string();
+}
@@ -0,0 +1,291 @@
+#include "Emulators/HackEmulator/WideHackEmulator.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    const int16_t ZERO_JMP = static_cast<int16_t>(0b1110101010000111);   // 0;JMP
+
+    // r[l] = f(l) for every lane; kept as a plain loop so it vectorizes
+    template <size_t Lanes, typename F>
+    inline void forLanes(std::array<int16_t, Lanes>& r, F f) {
+        for (size_t l = 0; l < Lanes; l++) {
+            r[l] = static_cast<int16_t>(f(l));
+        }
+    }
+}
+
+template <size_t Lanes>
+WideHackEmulator<Lanes>::WideHackEmulator() {
+    rom.assign(HackEmulator::ROM_MAX_SIZE, 0);
+    halt_loop.assign(HackEmulator::ROM_MAX_SIZE, 0);
+    reset();
+}
+
+template <size_t Lanes>
+void WideHackEmulator<Lanes>::reset() {
+    ram.assign(RAM_SPACE * Lanes, 0);
+    a_register.fill(0);
+    d_register.fill(0);
+    program_counter.fill(0);
+    cycle_count.fill(0);
+    step_count = 0;
+}
+
+template <size_t Lanes>
+void WideHackEmulator<Lanes>::loadProgram(const std::vector<int16_t>& instructions) {
+    if (instructions.size() > HackEmulator::ROM_MAX_SIZE) {
+        throw std::runtime_error("Program size exceeds maximum Hack ROM capacity (32768 instructions).");
+    }
+    rom.assign(HackEmulator::ROM_MAX_SIZE, 0);
+    std::copy(instructions.begin(), instructions.end(), rom.begin());
+
+    halt_loop.assign(HackEmulator::ROM_MAX_SIZE, 0);
+    for (uint16_t pc = 0; pc + 1u < HackEmulator::ROM_MAX_SIZE; pc++) {
+        halt_loop[pc] = rom[pc] == static_cast<int16_t>(pc) && rom[pc + 1] == ZERO_JMP;
+    }
+    program_counter.fill(0);
+}
+
+// --- Lockstep Execution ---
+
+template <size_t Lanes>
+std::array<RunResult, Lanes> WideHackEmulator<Lanes>::run(uint64_t maxCycles) {
+    const std::array<uint64_t, Lanes> start = cycle_count;
+    std::array<bool, Lanes> halted = {};
+
+    // Budgets are counted down in 32-bit chunks, which keeps the per-step
+    // bookkeeping as narrow as the registers
+    const uint64_t CHUNK = std::numeric_limits<int32_t>::max();
+    uint64_t done = 0;
+    while (done < maxCycles) {
+        const uint64_t chunk = std::min(CHUNK, maxCycles - done);
+        std::array<int32_t, Lanes> remaining;
+        for (size_t l = 0; l < Lanes; l++) {
+            remaining[l] = halted[l] ? 0 : static_cast<int32_t>(chunk);
+        }
+        runChunk(remaining, halted);
+        done += chunk;
+
+        // Once every lane has halted the rest of the budget would only spin
+        if (std::all_of(halted.begin(), halted.end(), [](bool h) { return h; })) {
+            break;
+        }
+    }
+
+    std::array<RunResult, Lanes> results;
+    for (size_t l = 0; l < Lanes; l++) {
+        results[l] = { cycle_count[l] - start[l], halted[l] ? StopReason::HALTED : StopReason::CYCLE_LIMIT,
+                       program_counter[l] };
+    }
+    return results;
+}
+
+template <size_t Lanes>
+void WideHackEmulator<Lanes>::runChunk(std::array<int32_t, Lanes>& remaining, std::array<bool, Lanes>& halted) {
+    const uint32_t IDLE = 0x10000;           // Above every PC
+    std::array<uint32_t, Lanes> key;
+    Mask mask;
+
+    while (true) {
+        // Lowest PC first, so lanes ahead of a branch wait for the others
+        for (size_t l = 0; l < Lanes; l++) {
+            key[l] = remaining[l] > 0 ? program_counter[l] : IDLE;
+        }
+        uint32_t group = IDLE;
+        for (size_t l = 0; l < Lanes; l++) {
+            group = std::min(group, key[l]);
+        }
+        if (group == IDLE) {
+            break;
+        }
+        uint32_t others = IDLE;              // Lowest PC of the running lanes left out
+        int32_t budget = std::numeric_limits<int32_t>::max();
+        for (size_t l = 0; l < Lanes; l++) {
+            bool member = key[l] == group;
+            mask[l] = static_cast<int16_t>(-static_cast<int16_t>(member));
+            others = std::min(others, member ? IDLE : key[l]);
+            budget = std::min(budget, member ? remaining[l] : budget);
+        }
+
+        // The group keeps stepping together until it splits, reaches a lane
+        // left behind earlier, or one of its lanes runs out of budget
+        uint32_t pc = group;
+        int32_t steps = 0;
+        while (true) {
+            if (pc < HackEmulator::ROM_MAX_SIZE && halt_loop[pc]) {
+                for (size_t l = 0; l < Lanes; l++) {
+                    halted[l] = halted[l] || mask[l];
+                    remaining[l] = mask[l] ? 0 : remaining[l];
+                }
+                break;
+            }
+            int16_t instruction = rom[pc & (HackEmulator::ROM_MAX_SIZE - 1)];
+            if (instruction >= 0) {
+                executeA(instruction, mask);
+                pc = (pc + 1) & 0xFFFF;
+            } else if (executeC(instruction, mask)) {
+                pc = program_counter[leadLane(mask)];
+                if (!sameProgramCounter(mask, static_cast<uint16_t>(pc))) {
+                    steps++;
+                    break;
+                }
+            } else {
+                pc = (pc + 1) & 0xFFFF;
+            }
+            steps++;
+            if (steps == budget || pc >= others) {
+                break;
+            }
+        }
+        for (size_t l = 0; l < Lanes; l++) {
+            remaining[l] -= steps & mask[l];
+            cycle_count[l] += static_cast<uint32_t>(steps & mask[l]);
+        }
+        step_count += steps;
+    }
+}
+
+template <size_t Lanes>
+size_t WideHackEmulator<Lanes>::leadLane(const Mask& mask) {
+    size_t lane = 0;
+    while (!mask[lane]) {
+        lane++;
+    }
+    return lane;
+}
+
+template <size_t Lanes>
+bool WideHackEmulator<Lanes>::sameProgramCounter(const Mask& mask, uint16_t pc) const {
+    int16_t differs = 0;
+    for (size_t l = 0; l < Lanes; l++) {
+        differs |= mask[l] & -static_cast<int16_t>(program_counter[l] != pc);
+    }
+    return differs == 0;
+}
+
+template <size_t Lanes>
+void WideHackEmulator<Lanes>::executeA(int16_t instruction, const Mask& mask) {
+    for (size_t l = 0; l < Lanes; l++) {
+        a_register[l] = static_cast<int16_t>((instruction & mask[l]) | (a_register[l] & ~mask[l]));
+        program_counter[l] = static_cast<uint16_t>(program_counter[l] + (mask[l] & 1));
+    }
+}
+
+template <size_t Lanes>
+bool WideHackEmulator<Lanes>::executeC(int16_t instruction, const Mask& mask) {
+    const std::array<int16_t, Lanes>& a = a_register;
+    const std::array<int16_t, Lanes>& d = d_register;
+
+    std::array<uint32_t, Lanes> address;
+    for (size_t l = 0; l < Lanes; l++) {
+        address[l] = (static_cast<uint16_t>(a[l]) & (RAM_SPACE - 1)) * Lanes + l;
+    }
+    std::array<int16_t, Lanes> y = a;
+    if (instruction & 0x1000) {
+        for (size_t l = 0; l < Lanes; l++) {
+            y[l] = ram[address[l]];
+        }
+    }
+
+    std::array<int16_t, Lanes> r;
+    switch ((instruction >> 6) & 0x3F) {
+        case 0b101010: r.fill(0); break;
+        case 0b111111: r.fill(1); break;
+        case 0b111010: r.fill(-1); break;
+        case 0b001100: r = d; break;
+        case 0b001101: forLanes(r, [&](size_t l) { return ~d[l]; }); break;
+        case 0b001111: forLanes(r, [&](size_t l) { return -d[l]; }); break;
+        case 0b011111: forLanes(r, [&](size_t l) { return d[l] + 1; }); break;
+        case 0b001110: forLanes(r, [&](size_t l) { return d[l] - 1; }); break;
+        case 0b110000: r = y; break;
+        case 0b110001: forLanes(r, [&](size_t l) { return ~y[l]; }); break;
+        case 0b110011: forLanes(r, [&](size_t l) { return -y[l]; }); break;
+        case 0b110111: forLanes(r, [&](size_t l) { return y[l] + 1; }); break;
+        case 0b110010: forLanes(r, [&](size_t l) { return y[l] - 1; }); break;
+        case 0b000010: forLanes(r, [&](size_t l) { return d[l] + y[l]; }); break;
+        case 0b010011: forLanes(r, [&](size_t l) { return d[l] - y[l]; }); break;
+        case 0b000111: forLanes(r, [&](size_t l) { return y[l] - d[l]; }); break;
+        case 0b000000: forLanes(r, [&](size_t l) { return d[l] & y[l]; }); break;
+        case 0b010101: forLanes(r, [&](size_t l) { return d[l] | y[l]; }); break;
+        default:
+            throw std::runtime_error("Invalid ALU comp code: " + std::to_string((instruction >> 6) & 0x3F));
+    }
+
+    // M is written at the A the instruction started with
+    if (instruction & HackEmulator::DEST_M) {
+        for (size_t l = 0; l < Lanes; l++) {
+            if (mask[l]) {
+                ram[address[l]] = r[l];
+            }
+        }
+    }
+    if (instruction & HackEmulator::DEST_D) {
+        for (size_t l = 0; l < Lanes; l++) {
+            d_register[l] = static_cast<int16_t>((r[l] & mask[l]) | (d_register[l] & ~mask[l]));
+        }
+    }
+    if (instruction & HackEmulator::DEST_A) {
+        for (size_t l = 0; l < Lanes; l++) {
+            a_register[l] = static_cast<int16_t>((r[l] & mask[l]) | (a_register[l] & ~mask[l]));
+        }
+    }
+
+    const uint8_t jump = instruction & (HackEmulator::JUMP_GT | HackEmulator::JUMP_EQ | HackEmulator::JUMP_LT);
+    if (jump == 0) {
+        for (size_t l = 0; l < Lanes; l++) {
+            program_counter[l] = static_cast<uint16_t>(program_counter[l] + (mask[l] & 1));
+        }
+        return false;
+    }
+    // Each test yields 0 or -1, so the loop has no branches
+    const int16_t gt = (jump & HackEmulator::JUMP_GT) ? -1 : 0;
+    const int16_t eq = (jump & HackEmulator::JUMP_EQ) ? -1 : 0;
+    const int16_t lt = (jump & HackEmulator::JUMP_LT) ? -1 : 0;
+    for (size_t l = 0; l < Lanes; l++) {
+        int16_t taken = (gt & -static_cast<int16_t>(r[l] > 0)) | (eq & -static_cast<int16_t>(r[l] == 0)) |
+                        (lt & -static_cast<int16_t>(r[l] < 0));
+        taken &= mask[l];
+        int16_t next = static_cast<int16_t>(program_counter[l] + (mask[l] & 1));
+        program_counter[l] = static_cast<uint16_t>((a_register[l] & taken) | (next & ~taken));
+    }
+    return true;
+}
+
+// --- Lane Access ---
+
+template <size_t Lanes>
+void WideHackEmulator<Lanes>::checkLane(size_t lane) const {
+    if (lane >= Lanes) {
+        throw std::out_of_range("Lane " + std::to_string(lane) + " out of range for " + std::to_string(Lanes) + " lanes");
+    }
+}
+
+template <size_t Lanes>
+int16_t WideHackEmulator<Lanes>::peek(size_t lane, uint16_t addr) const {
+    checkLane(lane);
+    if (addr >= RAM_SPACE) {
+        throw std::out_of_range("Illegal memory access at " + std::to_string(addr));
+    }
+    return ram[addr * Lanes + lane];
+}
+
+template <size_t Lanes>
+void WideHackEmulator<Lanes>::setRamValue(size_t lane, uint16_t addr, int16_t value) {
+    checkLane(lane);
+    if (addr >= RAM_SPACE) {
+        throw std::out_of_range("Illegal memory access at " + std::to_string(addr));
+    }
+    ram[addr * Lanes + lane] = value;
+}
+
+template <size_t Lanes>
+void WideHackEmulator<Lanes>::setRamValue(uint16_t addr, int16_t value) {
+    for (size_t lane = 0; lane < Lanes; lane++) {
+        setRamValue(lane, addr, value);
+    }
+}
+
+template class WideHackEmulator<8>;
+template class WideHackEmulator<16>;
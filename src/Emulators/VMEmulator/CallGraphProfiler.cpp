@@ -0,0 +1,125 @@
+#include "Emulators/VMEmulator/CallGraphProfiler.hpp"
+#include "Emulators/VMEmulator/VMEmulator.hpp"
+#include <algorithm>
+#include <iomanip>
+
+CallGraphProfiler::CallGraphProfiler() {
+    reset();
+}
+
+void CallGraphProfiler::reset() {
+    function_ids.assign(ADDRESS_SPACE + 1, NO_FUNCTION);
+    functions.clear();
+    nodes.clear();
+    children.clear();
+    stack.clear();
+    total = 0;
+    last_step = 0;
+}
+
+uint32_t CallGraphProfiler::functionId(uint32_t address) {
+    uint32_t& id = function_ids[address < ADDRESS_SPACE ? address : ADDRESS_SPACE];
+    if (id == NO_FUNCTION) {
+        id = static_cast<uint32_t>(functions.size());
+        functions.push_back({ address });
+    }
+    return id;
+}
+
+// --- Call Stack ---
+
+void CallGraphProfiler::onStart(int32_t function) {
+    if (stack.empty()) {
+        push(function < 0 ? ADDRESS_SPACE : static_cast<uint32_t>(function));
+        functions[stack.back().function].calls--;
+    }
+}
+
+void CallGraphProfiler::push(uint32_t address) {
+    uint32_t id = functionId(address);
+    uint32_t parent = stack.empty() ? NO_NODE : stack.back().node;
+
+    uint64_t key = (static_cast<uint64_t>(parent) << 32) | id;
+    auto it = children.find(key);
+    uint32_t node;
+    if (it != children.end()) {
+        node = it->second;
+    } else {
+        node = static_cast<uint32_t>(nodes.size());
+        nodes.push_back({ parent, id });
+        children.emplace(key, node);
+    }
+
+    Function& function = functions[id];
+    function.calls++;
+    if (function.active++ == 0) {
+        function.outermostEntry = total;
+    }
+    stack.push_back({ id, node });
+}
+
+// A return from the outermost frame leaves it in place
+void CallGraphProfiler::pop() {
+    if (stack.size() < 2) {
+        return;
+    }
+    Function& function = functions[stack.back().function];
+    if (--function.active == 0) {
+        function.inclusive += total - function.outermostEntry;
+    }
+    stack.pop_back();
+}
+
+// --- Reports ---
+
+std::string CallGraphProfiler::nameOf(uint32_t function, const VMEmulator& vm) const {
+    uint32_t address = functions[function].address;
+    std::string name = address < ADDRESS_SPACE ? vm.getFunctionName(static_cast<uint16_t>(address)) : "";
+    return name.empty() ? "(top)" : name;
+}
+
+std::vector<CallGraphProfiler::FunctionStats> CallGraphProfiler::getFunctions(const VMEmulator& vm) const {
+    std::vector<FunctionStats> stats;
+    for (uint32_t id = 0; id < functions.size(); id++) {
+        const Function& function = functions[id];
+        // Frames still on the stack count up to now
+        uint64_t inclusive = function.inclusive + (function.active > 0 ? total - function.outermostEntry : 0);
+        stats.push_back({ nameOf(id, vm), function.calls, inclusive, function.exclusive });
+    }
+    std::stable_sort(stats.begin(), stats.end(), [](const FunctionStats& a, const FunctionStats& b) {
+        return a.exclusive > b.exclusive;
+    });
+    return stats;
+}
+
+void CallGraphProfiler::writeFolded(std::ostream& out, const VMEmulator& vm) const {
+    std::vector<std::string> paths(nodes.size());
+    std::vector<std::string> lines;
+    // Parents always come before their children
+    for (uint32_t node = 0; node < nodes.size(); node++) {
+        const Node& n = nodes[node];
+        std::string name = nameOf(n.function, vm);
+        paths[node] = n.parent == NO_NODE ? name : paths[n.parent] + ";" + name;
+        if (n.exclusive > 0) {
+            lines.push_back(paths[node] + " " + std::to_string(n.exclusive));
+        }
+    }
+    std::sort(lines.begin(), lines.end());
+    for (const std::string& line : lines) {
+        out << line << "\n";
+    }
+}
+
+void CallGraphProfiler::writeReport(std::ostream& out, const VMEmulator& vm, size_t top) const {
+    std::vector<FunctionStats> stats = getFunctions(vm);
+    out << "Functions by exclusive commands (" << total << " total)\n";
+    out << std::left << std::setw(36) << "Function" << std::right << std::setw(12) << "Calls"
+        << std::setw(16) << "Inclusive" << std::setw(16) << "Exclusive" << std::setw(9) << "%" << "\n";
+    for (size_t i = 0; i < stats.size() && i < top; i++) {
+        const FunctionStats& s = stats[i];
+        double percent = total == 0 ? 0.0 : 100.0 * static_cast<double>(s.exclusive) / static_cast<double>(total);
+        out << std::left << std::setw(36) << s.name << std::right << std::setw(12) << s.calls
+            << std::setw(16) << s.inclusive << std::setw(16) << s.exclusive
+            << std::setw(8) << std::fixed << std::setprecision(1) << percent << "%\n";
+    }
+}
@@ -0,0 +1,197 @@
+#include "Emulators/VMEmulator/OSIntrinsics.hpp"
+#include "Emulators/VMEmulator/VMEmulator.hpp"
+
+// Each function below follows its Jack source line by line, with the same
+// 16-bit wraparound and the same order of RAM reads and writes.
+
+namespace {
+    int16_t wrap(int32_t value) {
+        return static_cast<int16_t>(static_cast<uint16_t>(value));
+    }
+
+    // RAM word at a computed Jack address
+    int16_t& at(int16_t* ram, int32_t address) {
+        return ram[static_cast<uint16_t>(address) & 0x7FFF];
+    }
+
+    int16_t abs16(int16_t x) {
+        return x < 0 ? wrap(-x) : x;
+    }
+
+    // Math.divide; false where the Jack code would divide by zero
+    bool divide(int16_t x, int16_t y, int16_t& result) {
+        if (y == 0) {
+            return false;
+        }
+        int16_t absX = abs16(x);
+        int16_t absY = abs16(y);
+        if (absY > absX) {
+            result = 0;
+            return true;
+        }
+
+        int16_t q = 0;
+        if (absY < 16384 && !(wrap(absY + absY) > absX)) {
+            if (!divide(absX, wrap(absY + absY), q)) {
+                return false;
+            }
+        }
+
+        int16_t twoQY = wrap(2u * static_cast<uint16_t>(q) * static_cast<uint16_t>(absY));
+        int16_t quotient = wrap(absX - twoQY) < absY ? wrap(q + q) : wrap(q + q + 1);
+        result = (x < 0) == (y < 0) ? quotient : wrap(-quotient);
+        return true;
+    }
+
+    // Screen.drawPixelsAt, including the Memory.peek and Memory.poke it calls
+    void drawPixelsAt(int16_t* ram, const int16_t* color, const int16_t* screenBase,
+                      const int16_t* mem, int16_t screenOffset, int16_t mask) {
+        int16_t address = wrap(*screenBase + screenOffset);
+        int16_t original = at(ram, *mem + address);
+        at(ram, *mem + address) = *color != 0 ? static_cast<int16_t>(original | mask)
+                                              : static_cast<int16_t>(original & ~mask);
+        ram[VMEmulator::TEMP_POINTER] = 0;
+    }
+}
+
+void OSIntrinsics::registerAll(VMEmulator& vm) {
+    vm.registerIntrinsic("Math.multiply", mathMultiply);
+    vm.registerIntrinsic("Math.divide", mathDivide);
+    vm.registerIntrinsic("Memory.alloc", memoryAlloc);
+    vm.registerIntrinsic("String.appendChar", stringAppendChar);
+    vm.registerIntrinsic("Screen.clearScreen", screenClearScreen);
+    vm.registerIntrinsic("Screen.drawHorizontalLine", screenDrawHorizontalLine);
+}
+
+// --- Math ---
+
+bool OSIntrinsics::mathMultiply(VMEmulator&, int16_t*, const int16_t* args, int16_t& result) {
+    // The shift-and-add loop covers all 16 bits of y
+    result = wrap(static_cast<uint32_t>(static_cast<uint16_t>(args[0])) * static_cast<uint16_t>(args[1]));
+    return true;
+}
+
+bool OSIntrinsics::mathDivide(VMEmulator&, int16_t*, const int16_t* args, int16_t& result) {
+    return divide(args[0], args[1], result);
+}
+
+// --- Memory ---
+
+bool OSIntrinsics::memoryAlloc(VMEmulator& vm, int16_t* ram, const int16_t* args, int16_t& result) {
+    int16_t size = args[0];
+    int16_t& freeList = ram[vm.getStaticAddress("Memory", 1)];
+    if (size < 1 || freeList == 0) {
+        return false;
+    }
+
+    // First fit; check the whole walk before writing anything
+    int16_t last = 0;
+    int16_t current = freeList;
+    while (at(ram, current - 1) < wrap(size + 1)) {
+        last = current;
+        current = at(ram, current - 2);
+        if (current == 0) {
+            return false;
+        }
+    }
+
+    int16_t& temp = ram[VMEmulator::TEMP_POINTER];
+    if (at(ram, current - 1) > wrap(size + 2)) {
+        temp = at(ram, current - 2);
+        at(ram, current + size) = temp;
+        temp = wrap(at(ram, current - 1) - wrap(size + 2));
+        at(ram, current + size + 1) = temp;
+        temp = size;
+        at(ram, current - 1) = temp;
+
+        if (last == 0) {
+            freeList = wrap(current + size + 2);
+        } else {
+            temp = wrap(current + size + 2);
+            at(ram, last - 2) = temp;
+        }
+    } else {
+        if (last == 0) {
+            freeList = at(ram, current - 2);
+        } else {
+            temp = at(ram, current - 2);
+            at(ram, last - 2) = temp;
+        }
+    }
+
+    result = current;
+    return true;
+}
+
+// --- String ---
+
+bool OSIntrinsics::stringAppendChar(VMEmulator&, int16_t* ram, const int16_t* args, int16_t& result) {
+    int16_t self = args[0];
+    int16_t c = args[1];
+
+    // Fields: raw, maxLength, length
+    int16_t raw = at(ram, self);
+    int16_t length = at(ram, self + 2);
+    ram[VMEmulator::TEMP_POINTER] = c;
+    at(ram, raw + length) = c;
+    at(ram, self + 2) = wrap(at(ram, self + 2) + 1);
+
+    result = self;
+    return true;
+}
+
+// --- Screen ---
+
+bool OSIntrinsics::screenClearScreen(VMEmulator& vm, int16_t* ram, const int16_t*, int16_t& result) {
+    const int16_t screenBase = ram[vm.getStaticAddress("Screen", 1)];
+    const int16_t* mem = &ram[vm.getStaticAddress("Memory", 0)];
+
+    int16_t screenEnd = wrap(screenBase + 8160);
+    for (int16_t address = screenBase; address < screenEnd; address = wrap(address + 1)) {
+        at(ram, *mem + address) = 0;
+        ram[VMEmulator::TEMP_POINTER] = 0;
+    }
+
+    result = 0;
+    return true;
+}
+
+bool OSIntrinsics::screenDrawHorizontalLine(VMEmulator& vm, int16_t* ram, const int16_t* args, int16_t& result) {
+    const int16_t* color = &ram[vm.getStaticAddress("Screen", 0)];
+    const int16_t* screenBase = &ram[vm.getStaticAddress("Screen", 1)];
+    const int16_t* fillByteFrom = &ram[vm.getStaticAddress("Screen", 5)];
+    const int16_t* fillByteTo = &ram[vm.getStaticAddress("Screen", 6)];
+    const int16_t* div16 = &ram[vm.getStaticAddress("Screen", 7)];
+    const int16_t* mul32 = &ram[vm.getStaticAddress("Screen", 8)];
+    const int16_t* mem = &ram[vm.getStaticAddress("Memory", 0)];
+    int16_t y = args[2];
+
+    int16_t currentX = args[0];
+    int16_t endX = wrap(args[1] + 1);
+    int16_t startBit = currentX & 15;
+    int16_t endBit = endX & 15;
+    int16_t currentByte = wrap(at(ram, *mul32 + y) + at(ram, *div16 + currentX));
+    int16_t endByte = wrap(at(ram, *mul32 + y) + at(ram, *div16 + endX));
+
+    if (currentByte == endByte) {
+        int16_t mask = at(ram, *fillByteFrom + startBit) & at(ram, *fillByteTo + endBit);
+        drawPixelsAt(ram, color, screenBase, mem, currentByte, mask);
+        result = 0;
+        return true;
+    }
+
+    if (startBit > 0) {
+        drawPixelsAt(ram, color, screenBase, mem, currentByte, at(ram, *fillByteFrom + startBit));
+        currentByte = wrap(currentByte + 1);
+    }
+
+    while (currentByte < endByte) {
+        drawPixelsAt(ram, color, screenBase, mem, currentByte, -1);
+        currentByte = wrap(currentByte + 1);
+    }
+
+    drawPixelsAt(ram, color, screenBase, mem, endByte, at(ram, *fillByteTo + endBit));
+
+    result = 0;
+    return true;
+}
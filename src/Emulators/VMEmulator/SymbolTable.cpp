@@ -1,5 +1,6 @@
 #include "Emulators/VMEmulator/SymbolTable.hpp"
 #include <algorithm>
+#include <stdexcept>
 
 void SymbolTable::addLabel(const std::string& fileName, const std::string& labelName, int16_t address) {
     labels[fileName][labelName] = address;
@@ -7,10 +8,33 @@ void SymbolTable::addLabel(const std::string& fileName, const std::string& label
 
 void SymbolTable::addFunction(const std::string& functionName, int16_t address, int16_t locals) {
     functions[functionName] = { address, locals };
+    functionNames[address] = functionName;
 }
 
-void SymbolTable::registerFileRange(const std::string& fileName, int16_t startAddress) {
-    fileRanges.push_back({startAddress, fileName});
+void SymbolTable::registerFileRange(const std::string& fileName, int16_t startAddress, uint16_t staticBase) {
+    fileRanges.push_back({startAddress, fileName, staticBase});
+}
+
+int16_t SymbolTable::getFunctionStart(int16_t pc) const {
+    auto it = functionNames.upper_bound(pc);
+    if (it == functionNames.begin()) {
+        return -1;
+    }
+    return std::prev(it)->first;
+}
+
+std::string SymbolTable::getFunctionName(int16_t address) const {
+    auto it = functionNames.find(address);
+    return it == functionNames.end() ? "" : it->second;
+}
+
+uint16_t SymbolTable::getStaticBase(const std::string& fileName) const {
+    for (const FileRange& range : fileRanges) {
+        if (range.fileName == fileName) {
+            return range.staticBase;
+        }
+    }
+    throw std::runtime_error("File not loaded: " + fileName);
 }
 
 std::string SymbolTable::getFileNameFromPC(int16_t pc) const {
@@ -38,7 +62,7 @@ int16_t SymbolTable::getAddressFromLabel(int16_t currentPC, const std::string& l
             return labelIt->second;
         }
     }
-    throw std::runtime_error("Label not found: " + labelName);
+    throw std::runtime_error("Label not found: " + labelName + (currentFile.empty() ? "" : " in " + currentFile));
 }
 
 FunctionEntry SymbolTable::getFunctionAddress(const std::string& functionName) const {
@@ -55,4 +79,5 @@ void SymbolTable::clear() {
     labels.clear();
     fileRanges.clear();
     functions.clear();
+    functionNames.clear();
 }
\ No newline at end of file
@@ -1,247 +1,547 @@
 #include "Emulators/VMEmulator/VMEmulator.hpp"
 #include "Emulators/VMEmulator/VMParser.hpp"
-#include <sstream>
+#include "Emulators/VMEmulator/OSIntrinsics.hpp"
+#include "Emulators/VMEmulator/CallGraphProfiler.hpp"
 #include <filesystem>
 namespace fs = std::filesystem;
 
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO 1
+const bool VMEmulator::THREADED_DISPATCH_SUPPORTED = true;
+#else
+const bool VMEmulator::THREADED_DISPATCH_SUPPORTED = false;
+#endif
+
 VMEmulator::VMEmulator() {
     ram.resize(32768, 0);
     ram[0] = 256;
-    initDispatchTables();
-    initSegmentMap();
+    OSIntrinsics::registerAll(*this);
 }
 
 void VMEmulator::loadRawProgram(const std::vector<std::string>& instructions) {
-    rom.clear();
-    rom = instructions;
+    parser.clear();
+    symbolTable.clear();
+    parser.loadLines("", instructions, symbolTable);
+    parser.link(symbolTable);
+    rom = parser.getBytecode();
+    fused_rom = VMParser::fuse(rom);
     program_counter = 0;
+    bindIntrinsics();
 }
 
 void VMEmulator::loadProgram(const std::string& path) {
     parser.clear();
+    symbolTable.clear();
 
     if (fs::is_directory(path)) {
-        for (const auto& entry : fs::directory_iterator(path)) {
-            if (entry.path().extension() == ".vm") {
-                parser.loadFile(entry.path().string(), symbolTable);
-            }
-        }
+        parser.loadDirectory(path, symbolTable);
     } else {
         parser.loadFile(path, symbolTable);
     }
-    loadRawProgram(parser.getInstructions());
+    parser.link(symbolTable);
+    rom = parser.getBytecode();
+    fused_rom = VMParser::fuse(rom);
+    program_counter = 0;
+    bindIntrinsics();
+
+    if (symbolTable.hasFunction("Sys.init")) {
+        bootstrap();
+    }
 }
 
-void VMEmulator::initDispatchTables() {
-    auto addComp = [this](std::string name, std::function<bool(int16_t, int16_t)> comp) {
-        binaryOps[name] = [this, comp]() {
-            int16_t y = stackPop();
-            int16_t x = stackPop();
-            stackPush(comp(x, y) ? -1 : 0);
-        };
+void VMEmulator::bootstrap() {
+    FunctionEntry entry = symbolTable.getFunctionAddress("Sys.init");
+    ram[STACK_POINTER] = 256;
+    const int16_t frame[] = {
+        static_cast<int16_t>(rom.size()), ram[LCL_POINTER], ram[ARG_POINTER], ram[THIS_POINTER], ram[THAT_POINTER]
     };
+    for (int16_t value : frame) {
+        ram[ram[STACK_POINTER]++] = value;
+    }
+    ram[ARG_POINTER] = 256;
+    ram[LCL_POINTER] = ram[STACK_POINTER];
+    for (int i = 0; i < entry.numLocals; ++i) {
+        ram[ram[STACK_POINTER]++] = 0;
+    }
+    program_counter = static_cast<uint16_t>(entry.address);
+}
 
-    addComp("eq", [](int16_t a, int16_t b) { return a == b; });
-    addComp("gt", [](int16_t a, int16_t b) { return a > b; });
-    addComp("lt", [](int16_t a, int16_t b) { return a < b; });
-
-    binaryOps["add"] = [this]() { stackPush(stackPop() + stackPop()); };
-    binaryOps["and"] = [this]() { stackPush(stackPop() & stackPop()); };
-    binaryOps["or"]  = [this]() { stackPush(stackPop() | stackPop()); };
-    
-    binaryOps["sub"] = [this]() { 
-        int16_t y = stackPop(); 
-        int16_t x = stackPop(); 
-        stackPush(x - y); 
-    };
+// --- Intrinsics ---
 
-    unaryOps["neg"] = [this]() { stackPush(-stackPop()); };
-    unaryOps["not"] = [this]() { stackPush(~stackPop()); };
+void VMEmulator::registerIntrinsic(const std::string& functionName, VMIntrinsic implementation) {
+    intrinsics[functionName] = { implementation, false };
+    bindIntrinsics();
 }
 
-void VMEmulator::initSegmentMap() {
-    segmentMap["local"]    = Segment::LOCAL;
-    segmentMap["argument"] = Segment::ARG;
-    segmentMap["this"]     = Segment::THIS;
-    segmentMap["that"]     = Segment::THAT;
-    segmentMap["constant"] = Segment::CONSTANT;
-    segmentMap["static"]   = Segment::STATIC;
-    segmentMap["pointer"]  = Segment::POINTER;
-    segmentMap["temp"]     = Segment::TEMP;
+void VMEmulator::setIntrinsic(const std::string& functionName, bool enabled) {
+    auto it = intrinsics.find(functionName);
+    if (it == intrinsics.end()) {
+        throw std::runtime_error("No intrinsic registered for " + functionName);
+    }
+    it->second.enabled = enabled;
+    bindIntrinsics();
 }
 
-void VMEmulator::executeNextInstruction() {
-    std::string raw = fetch();
-    if (raw.empty()) return;
-    
-    DecodedInstruction decoded = decode(raw);
-    execute(decoded); 
+void VMEmulator::setIntrinsics(bool enabled) {
+    for (auto& [name, entry] : intrinsics) {
+        entry.enabled = enabled;
+    }
+    bindIntrinsics();
+}
+
+bool VMEmulator::isIntrinsicEnabled(const std::string& functionName) const {
+    auto it = intrinsics.find(functionName);
+    return it != intrinsics.end() && it->second.enabled;
 }
 
-std::string VMEmulator::fetch() {
-    if (program_counter >= rom.size()) {
-        return "";
+std::vector<std::string> VMEmulator::getIntrinsicNames() const {
+    std::vector<std::string> names;
+    for (const auto& [name, entry] : intrinsics) {
+        names.push_back(name);
     }
-    return rom[program_counter++];
+    return names;
 }
 
-DecodedInstruction VMEmulator::decode(std::string instruction) {
-    DecodedInstruction decoded;
-    std::stringstream ss(instruction);
-    std::string firstWord;
-    ss >> firstWord;
-
-    if (firstWord == "push" || firstWord == "pop") {
-        decoded.type = (firstWord == "push") ? InstructionType::PUSH : InstructionType::POP;
-        std::string segStr;
-        ss >> segStr >> decoded.value;
-        if (segmentMap.find(segStr) != segmentMap.end()) {
-            decoded.segment = segmentMap[segStr];
-        } else {
-            throw std::runtime_error("Unknown segment: " + segStr);
-        }
-    } else if (firstWord == "goto") {
-        decoded.type = InstructionType::GOTO;
-        ss >> decoded.command;
-    } else if (firstWord == "if-goto") {
-        decoded.type = InstructionType::IF_GOTO;
-        ss >> decoded.command;
-    } else if (firstWord == "call") {
-        decoded.type = InstructionType::FUNCTION_CALL;
-        std::string funcName;
-        int nArgs;
-        
-        if (ss >> funcName >> nArgs) {
-            decoded.command = funcName;
-            decoded.value = nArgs;
-        } else {
-            throw std::runtime_error("Invalid call command: " + instruction);
-        }
-    } else if (firstWord == "return") {
-        decoded.type = InstructionType::RETURN;
-    } else {
-        if (binaryOps.find(firstWord) != binaryOps.end()) {
-            decoded.type = InstructionType::BINARY_ARITHMETIC;
-            decoded.command = firstWord;
-        } else if (unaryOps.find(firstWord) != unaryOps.end()) {
-            decoded.type = InstructionType::UNARY_ARITHMETIC;
-            decoded.command = firstWord;
+void VMEmulator::bindIntrinsics() {
+    boundIntrinsics.clear();
+    for (const auto& [name, entry] : intrinsics) {
+        if (entry.enabled && symbolTable.hasFunction(name)) {
+            boundIntrinsics.resize(rom.size() + 1, nullptr);
+            boundIntrinsics[symbolTable.getFunctionAddress(name).address] = entry.implementation;
         }
     }
-    return decoded;
 }
 
-void VMEmulator::execute(DecodedInstruction decoded) {
-    switch (decoded.type) {
-        case InstructionType::PUSH:              executePush(decoded);             break;
-        case InstructionType::POP:               executePop(decoded);              break;
-        case InstructionType::UNARY_ARITHMETIC:  executeUnaryArithmetic(decoded);  break;
-        case InstructionType::BINARY_ARITHMETIC: executeBinaryArithmetic(decoded); break;
-        case InstructionType::FUNCTION_CALL:     executeFunctionCall(decoded);     break;
-        case InstructionType::RETURN:            executeReturn(decoded);           break;
-        case InstructionType::GOTO:
-            program_counter = symbolTable.getAddressFromLabel(program_counter - 1, decoded.command);
-            break;
-
-        case InstructionType::IF_GOTO:
-            if (stackPop() != 0) {
-                program_counter = symbolTable.getAddressFromLabel(program_counter - 1, decoded.command);
-            }
-            break;
-    }
+// A single step gains nothing from threading
+void VMEmulator::executeNextInstruction() {
+    NullObserver none;
+    interpret<false, false>(1, none);
 }
 
-void VMEmulator::executePush(DecodedInstruction decoded) {
-    int16_t valueToPush = 0;
+uint64_t VMEmulator::executeInstructions(uint64_t count) {
+    NullObserver none;
+    return interpretSelected(count, none);
+}
 
-    switch (decoded.segment) {
-        case Segment::CONSTANT: valueToPush = decoded.value; break;
-        case Segment::LOCAL:    valueToPush = peekLocal(decoded.value); break;
-        case Segment::ARG:      valueToPush = peekArgument(decoded.value); break;
-        case Segment::THIS:     valueToPush = peekThis(decoded.value); break;
-        case Segment::THAT:     valueToPush = peekThat(decoded.value); break;
-        case Segment::POINTER:  valueToPush = peekPointer(decoded.value); break;
-        case Segment::TEMP:     valueToPush = peekTemp(decoded.value); break;
-        case Segment::STATIC:   valueToPush = peekStatic(decoded.value); break;
+uint64_t VMEmulator::executeInstructions(uint64_t count, CallGraphProfiler& profiler) {
+    profiler.onStart(symbolTable.getFunctionStart(static_cast<int16_t>(program_counter)));
+    return interpretSelected(count, profiler);
+}
 
-        default: throw std::runtime_error("Unknown segment for push");
+template <typename Observer>
+uint64_t VMEmulator::interpretSelected(uint64_t maxSteps, Observer& observer, const StopConditions& stop) {
+    if (dispatch == VMDispatch::THREADED) {
+        return stack_caching ? interpret<true, true>(maxSteps, observer, stop)
+                             : interpret<true, false>(maxSteps, observer, stop);
     }
-
-    stackPush(valueToPush);
+    return stack_caching ? interpret<false, true>(maxSteps, observer, stop)
+                         : interpret<false, false>(maxSteps, observer, stop);
 }
 
-void VMEmulator::executePop(DecodedInstruction decoded) {
-    int16_t val = stackPop();
-
-    switch (decoded.segment) {
-        case Segment::CONSTANT: 
-            throw std::runtime_error("Cannot pop into constant segment");
-            
-        case Segment::LOCAL:    pokeLocal(decoded.value, val); break;
-        case Segment::ARG:      pokeArgument(decoded.value, val); break;
-        case Segment::THIS:     pokeThis(decoded.value, val); break;
-        case Segment::THAT:     pokeThat(decoded.value, val); break;
-        case Segment::POINTER:  pokePointer(decoded.value, val); break;
-        case Segment::TEMP:     pokeTemp(decoded.value, val); break; 
-        case Segment::STATIC:   pokeStatic(decoded.value, val); break;
-
-        default: throw std::runtime_error("Unknown segment for pop");
+VMRunResult VMEmulator::run(uint64_t maxSteps) {
+    StopConditions stop = { 0xFFFFFFFF, HEAP_BASE_ADDR, true };
+    // Like the END loop of the Project 8 tests
+    if (program_counter < rom.size() && rom[program_counter].opcode == Opcode::GOTO &&
+        rom[program_counter].target == program_counter) {
+        return { 0, VMStopReason::HALTED, program_counter, 0, "" };
+    }
+    if (symbolTable.hasFunction("Sys.halt")) {
+        stop.haltAddress = static_cast<uint16_t>(symbolTable.getFunctionAddress("Sys.halt").address);
+        if (symbolTable.getFunctionStart(static_cast<int16_t>(program_counter)) == static_cast<int32_t>(stop.haltAddress)) {
+            return { 0, VMStopReason::HALTED, program_counter, 0, "" };
+        }
     }
-}
 
-void VMEmulator::executeBinaryArithmetic(DecodedInstruction decoded) {
-    binaryOps[decoded.command]();
+    stop_error.clear();
+    NullObserver none;
+    uint64_t steps = interpretSelected(maxSteps, none, stop);
+
+    VMStopReason reason = stop_reason;
+    if (reason == VMStopReason::STEP_LIMIT && program_counter >= rom.size()) {
+        reason = VMStopReason::END_OF_PROGRAM;
+    }
+    uint16_t depth = static_cast<uint16_t>(std::max<int32_t>(peak_stack_pointer - STACK_BASE_ADDR, 0));
+    return { steps, reason, program_counter, depth, stop_error };
 }
 
-void VMEmulator::executeUnaryArithmetic(DecodedInstruction decoded) {
-    unaryOps[decoded.command]();  
+// Parses a command for inspection; running programs use the bytecode
+// packed at load time
+DecodedInstruction VMEmulator::decode(std::string instruction) {
+    DecodedInstruction decoded;
+    std::string symbol;
+    VMInstruction packed = VMParser::encode(instruction, symbol);
+    decoded.type = VMParser::typeOf(packed.opcode);
+    decoded.segment = packed.segment;
+    decoded.value = packed.value;
+    if (decoded.type == InstructionType::UNARY_ARITHMETIC || decoded.type == InstructionType::BINARY_ARITHMETIC) {
+        decoded.command = VMParser::mnemonic(packed.opcode);
+    } else {
+        decoded.command = symbol;
+    }
+    return decoded;
 }
 
-void VMEmulator::executeFunctionCall(DecodedInstruction decoded) {
-    FunctionEntry entry = symbolTable.getFunctionAddress(decoded.command);
-    stackPush(static_cast<int16_t>(program_counter));
+// --- Interpreter Core ---
+//
+// Every handler is both a case of the switch and a label. With SWITCH, a
+// handler ends by going back to the top of the loop; with THREADED it fetches
+// the next instruction itself and jumps to its handler, so each handler has
+// its own indirect branch for the predictor to learn.
+
+#define VM_HANDLER(op) case Opcode::op: op##_HANDLER
+
+#ifdef VM_COMPUTED_GOTO
+#define VM_NEXT()                                                             \
+    if constexpr (Threaded) {                                                 \
+        if (executed >= maxSteps || pc >= size) {                             \
+            goto done;                                                        \
+        }                                                                     \
+        instruction = &code[pc++];                                            \
+        executed++;                                                           \
+        goto *HANDLERS[static_cast<uint8_t>(instruction->opcode)];            \
+    } else {                                                                  \
+        continue;                                                             \
+    }
+#else
+#define VM_NEXT() continue
+#endif
+
+template <bool Threaded, bool CachedStack, typename Observer>
+uint64_t VMEmulator::interpret(uint64_t maxSteps, Observer& observer, const StopConditions& stop) {
+    const VMInstruction* code = superinstructions ? fused_rom.data() : rom.data();
+    const uint32_t size = static_cast<uint32_t>(rom.size());
+    int16_t* mem = ram.data();
+    uint32_t pc = program_counter;
+    uint64_t executed = 0;
+    const VMInstruction* instruction = nullptr;
+    const VMIntrinsic* intrinsicAt = boundIntrinsics.empty() ? nullptr : boundIntrinsics.data();
+    const uint32_t haltAddress = stop.haltAddress;
+    const int32_t stackLimit = stop.stackLimit;
+    const bool haltOnSelfGoto = stop.haltOnSelfGoto;
+    VMStopReason reason = VMStopReason::STEP_LIMIT;
+    int32_t peak = mem[STACK_POINTER];
+
+#ifdef VM_COMPUTED_GOTO
+    // In Opcode order
+    static const void* const HANDLERS[] = {
+        &&PUSH_CONSTANT_HANDLER, &&PUSH_LOCAL_HANDLER, &&PUSH_ARG_HANDLER, &&PUSH_POINTER_HANDLER,
+        &&PUSH_THIS_HANDLER, &&PUSH_THAT_HANDLER, &&PUSH_STATIC_HANDLER, &&PUSH_TEMP_HANDLER,
+        &&POP_LOCAL_HANDLER, &&POP_ARG_HANDLER, &&POP_POINTER_HANDLER, &&POP_THIS_HANDLER,
+        &&POP_THAT_HANDLER, &&POP_STATIC_HANDLER, &&POP_TEMP_HANDLER,
+        &&ADD_HANDLER, &&SUB_HANDLER, &&NEG_HANDLER, &&EQ_HANDLER, &&GT_HANDLER, &&LT_HANDLER,
+        &&AND_HANDLER, &&OR_HANDLER, &&NOT_HANDLER,
+        &&GOTO_HANDLER, &&IF_GOTO_HANDLER, &&CALL_HANDLER, &&RETURN_HANDLER,
+        &&ARRAY_READ_HANDLER, &&ARRAY_WRITE_HANDLER, &&NOT_IF_GOTO_HANDLER, &&PUSH_NOT_HANDLER,
+        &&DISCARD_HANDLER
+    };
+    static_assert(sizeof(HANDLERS) / sizeof(HANDLERS[0]) == static_cast<size_t>(Opcode::COUNT),
+                  "One handler per opcode");
+#endif
+
+    // The stack in RAM, as call and return lay out frames
+    auto ramPush = [mem, &peak](int16_t value) {
+        uint16_t sp = mem[STACK_POINTER];
+        mem[sp] = value;
+        mem[STACK_POINTER] = static_cast<int16_t>(sp + 1);
+        peak = std::max<int32_t>(peak, sp + 1);
+    };
+    auto ramPop = [mem]() -> int16_t {
+        uint16_t sp = static_cast<uint16_t>(mem[STACK_POINTER] - 1);
+        mem[STACK_POINTER] = sp;
+        return mem[sp];
+    };
 
-    stackPush(ram[LCL_POINTER]);
-    stackPush(ram[ARG_POINTER]);
-    stackPush(ram[THIS_POINTER]);
-    stackPush(ram[THAT_POINTER]);
+    // With CachedStack, SP lives in sp and the top word in tos; the words
+    // under it stay in RAM, and RAM's copy of the top is stale. spill() makes
+    // RAM whole again for code that works on it, reload() takes over again.
+    uint16_t sp = static_cast<uint16_t>(mem[STACK_POINTER]);
+    int16_t tos = CachedStack ? mem[(sp - 1) & ADDRESS_MASK] : 0;
+    auto spill = [&]() {
+        if constexpr (CachedStack) {
+            mem[(sp - 1) & ADDRESS_MASK] = tos;
+            mem[STACK_POINTER] = static_cast<int16_t>(sp);
+        }
+    };
+    auto reload = [&]() {
+        if constexpr (CachedStack) {
+            sp = static_cast<uint16_t>(mem[STACK_POINTER]);
+            tos = mem[(sp - 1) & ADDRESS_MASK];
+        }
+    };
 
-    ram[ARG_POINTER] = ram[STACK_POINTER] - 5 - decoded.value;
-    ram[LCL_POINTER] = ram[STACK_POINTER];
+    // Reads word only once the old top is back in RAM, in case word is it
+    auto push = [&](const int16_t& word) {
+        if constexpr (CachedStack) {
+            mem[sp - 1] = tos;
+            tos = word;
+            sp++;
+            peak = std::max<int32_t>(peak, sp);
+        } else {
+            ramPush(word);
+        }
+    };
+    auto pop = [&]() -> int16_t {
+        if constexpr (CachedStack) {
+            int16_t value = tos;
+            sp--;
+            tos = mem[sp - 1];
+            return value;
+        } else {
+            return ramPop();
+        }
+    };
+    // Writes word before the new top is read, in case word is it
+    auto popTo = [&](int16_t& word) {
+        if constexpr (CachedStack) {
+            int16_t value = tos;
+            sp--;
+            word = value;
+            tos = mem[sp - 1];
+        } else {
+            int16_t value = ramPop();
+            word = value;
+        }
+    };
+    // The word on top of the stack, for unary ops to rewrite in place
+    auto stackTop = [&]() -> int16_t& {
+        if constexpr (CachedStack) {
+            return tos;
+        } else {
+            return mem[static_cast<uint16_t>(mem[STACK_POINTER] - 1)];
+        }
+    };
+    // The second operand of a binary op is popped, the first is rewritten in place
+    auto binary = [&](auto op) {
+        if constexpr (CachedStack) {
+            sp--;
+            tos = static_cast<int16_t>(op(mem[sp - 1], tos));
+        } else {
+            uint16_t top = static_cast<uint16_t>(mem[STACK_POINTER] - 1);
+            mem[STACK_POINTER] = top;
+            mem[top - 1] = static_cast<int16_t>(op(mem[top - 1], mem[top]));
+        }
+    };
 
-    for (int i = 0; i < entry.numLocals; ++i) {
-        stackPush(0);
-    }
+    while (executed < maxSteps && pc < size) {
+        instruction = &code[pc++];
+        executed++;
+        switch (instruction->opcode) {
+            VM_HANDLER(PUSH_CONSTANT): push(instruction->value);                                   VM_NEXT();
+            VM_HANDLER(PUSH_LOCAL):    push(mem[mem[LCL_POINTER] + instruction->value]);           VM_NEXT();
+            VM_HANDLER(PUSH_ARG):      push(mem[mem[ARG_POINTER] + instruction->value]);           VM_NEXT();
+            VM_HANDLER(PUSH_POINTER):  push(mem[POINTER_POINTER + instruction->value]);            VM_NEXT();
+            VM_HANDLER(PUSH_THIS):     push(mem[mem[THIS_POINTER] + instruction->value]);          VM_NEXT();
+            VM_HANDLER(PUSH_THAT):     push(mem[mem[THAT_POINTER] + instruction->value]);          VM_NEXT();
+            VM_HANDLER(PUSH_STATIC):   push(mem[STATIC_BASE_ADDR + instruction->value]);           VM_NEXT();
+            VM_HANDLER(PUSH_TEMP):     push(mem[TEMP_POINTER + instruction->value]);               VM_NEXT();
+
+            VM_HANDLER(POP_LOCAL):     popTo(mem[mem[LCL_POINTER] + instruction->value]);          VM_NEXT();
+            VM_HANDLER(POP_ARG):       popTo(mem[mem[ARG_POINTER] + instruction->value]);          VM_NEXT();
+            VM_HANDLER(POP_POINTER):   popTo(mem[POINTER_POINTER + instruction->value]);           VM_NEXT();
+            VM_HANDLER(POP_THIS):      popTo(mem[mem[THIS_POINTER] + instruction->value]);         VM_NEXT();
+            VM_HANDLER(POP_THAT):      popTo(mem[mem[THAT_POINTER] + instruction->value]);         VM_NEXT();
+            VM_HANDLER(POP_STATIC):    popTo(mem[STATIC_BASE_ADDR + instruction->value]);          VM_NEXT();
+            VM_HANDLER(POP_TEMP):      popTo(mem[TEMP_POINTER + instruction->value]);              VM_NEXT();
+
+            VM_HANDLER(ADD): binary([](int16_t x, int16_t y) { return x + y; });               VM_NEXT();
+            VM_HANDLER(SUB): binary([](int16_t x, int16_t y) { return x - y; });               VM_NEXT();
+            VM_HANDLER(EQ):  binary([](int16_t x, int16_t y) { return x == y ? -1 : 0; });     VM_NEXT();
+            VM_HANDLER(GT):  binary([](int16_t x, int16_t y) { return x > y ? -1 : 0; });      VM_NEXT();
+            VM_HANDLER(LT):  binary([](int16_t x, int16_t y) { return x < y ? -1 : 0; });      VM_NEXT();
+            VM_HANDLER(AND): binary([](int16_t x, int16_t y) { return x & y; });               VM_NEXT();
+            VM_HANDLER(OR):  binary([](int16_t x, int16_t y) { return x | y; });               VM_NEXT();
+            VM_HANDLER(NEG): { int16_t& t = stackTop(); t = static_cast<int16_t>(-t); }            VM_NEXT();
+            VM_HANDLER(NOT): { int16_t& t = stackTop(); t = static_cast<int16_t>(~t); }            VM_NEXT();
+
+            VM_HANDLER(GOTO):
+                if (haltOnSelfGoto && instruction->target + 1u == pc) {
+                    pc = instruction->target;
+                    reason = VMStopReason::HALTED;
+                    goto done;
+                }
+                pc = instruction->target;
+                VM_NEXT();
+
+            VM_HANDLER(IF_GOTO):
+                if (pop() != 0) {
+                    pc = instruction->target;
+                }
+                VM_NEXT();
+
+            VM_HANDLER(CALL):
+                spill();
+                if (intrinsicAt != nullptr && intrinsicAt[instruction->target] != nullptr) {
+                    uint16_t args = static_cast<uint16_t>(mem[STACK_POINTER] - instruction->value);
+                    int16_t result;
+                    if (intrinsicAt[instruction->target](*this, mem, mem + args, result)) {
+                        // As if the function had returned
+                        mem[args] = result;
+                        mem[STACK_POINTER] = static_cast<int16_t>(args + 1);
+                        reload();
+                        if constexpr (Observer::enabled) {
+                            observer.onCall(instruction->target, executed);
+                            observer.onReturn(executed);
+                        }
+                        VM_NEXT();
+                    }
+                }
+
+                ramPush(static_cast<int16_t>(pc));
+
+                ramPush(mem[LCL_POINTER]);
+                ramPush(mem[ARG_POINTER]);
+                ramPush(mem[THIS_POINTER]);
+                ramPush(mem[THAT_POINTER]);
+
+                mem[ARG_POINTER] = mem[STACK_POINTER] - 5 - instruction->value;
+                mem[LCL_POINTER] = mem[STACK_POINTER];
+
+                for (int i = 0; i < instruction->locals; ++i) {
+                    ramPush(0);
+                }
+                reload();
+
+                pc = instruction->target;
+                if constexpr (Observer::enabled) {
+                    observer.onCall(instruction->target, executed);
+                }
+                if (pc == haltAddress) {
+                    reason = VMStopReason::HALTED;
+                    goto done;
+                }
+                if (mem[STACK_POINTER] > stackLimit) {
+                    reason = VMStopReason::ERROR;
+                    stop_error = "Stack overflow calling " + getFunctionName(static_cast<uint16_t>(pc));
+                    goto done;
+                }
+                VM_NEXT();
+
+            VM_HANDLER(RETURN): {
+                spill();
+                int16_t endFrame = mem[LCL_POINTER];
+                int16_t retAddr = mem[endFrame - 5];
+                mem[mem[ARG_POINTER]] = ramPop();
+                mem[STACK_POINTER] = mem[ARG_POINTER] + 1;
+
+                mem[THAT_POINTER] = mem[endFrame - 1];
+                mem[THIS_POINTER] = mem[endFrame - 2];
+                mem[ARG_POINTER]  = mem[endFrame - 3];
+                mem[LCL_POINTER]  = mem[endFrame - 4];
+                reload();
+
+                pc = static_cast<uint16_t>(retAddr);
+                if constexpr (Observer::enabled) {
+                    observer.onReturn(executed);
+                }
+                if (pc > size) {
+                    reason = VMStopReason::ERROR;
+                    stop_error = "Return to address " + std::to_string(pc) + " outside the program";
+                    goto done;
+                }
+                // The pop temp 0 of a do statement
+                if (pc < size && code[pc].opcode == Opcode::DISCARD && executed < maxSteps) {
+                    popTo(mem[TEMP_POINTER + code[pc].value]);
+                    pc++;
+                    executed++;
+                }
+                VM_NEXT();
+            }
 
-    program_counter = entry.address;
-}
+            // --- Superinstructions ---
+            // Each one runs its whole sequence or, when the step budget ends
+            // inside it, only the first command.
+
+            VM_HANDLER(ARRAY_READ): {
+                if (maxSteps - executed < 2) {
+                    goto ADD_HANDLER;
+                }
+                pc += 2;
+                executed += 2;
+                if constexpr (CachedStack) {
+                    sp--;
+                    mem[THAT_POINTER] = static_cast<int16_t>(mem[sp - 1] + tos);
+                    tos = mem[mem[THAT_POINTER]];
+                } else {
+                    uint16_t top = static_cast<uint16_t>(mem[STACK_POINTER] - 1);
+                    mem[STACK_POINTER] = top;
+                    mem[THAT_POINTER] = static_cast<int16_t>(mem[top - 1] + mem[top]);
+                    mem[top - 1] = mem[mem[THAT_POINTER]];
+                }
+                VM_NEXT();
+            }
 
-void VMEmulator::executeReturn(DecodedInstruction decoded) {
-    int16_t endFrame = ram[LCL_POINTER];
-    int16_t retAddr = ram[endFrame - 5];
-    ram[ram[ARG_POINTER]] = stackPop();
-    ram[STACK_POINTER] = ram[ARG_POINTER] + 1;
+            VM_HANDLER(ARRAY_WRITE): {
+                if (maxSteps - executed < 3) {
+                    goto POP_TEMP_HANDLER;
+                }
+                pc += 3;
+                executed += 3;
+                if constexpr (CachedStack) {
+                    int16_t v = tos;
+                    sp -= 2;
+                    mem[TEMP_POINTER + instruction->value] = v;
+                    mem[THAT_POINTER] = mem[sp];
+                    mem[mem[THAT_POINTER]] = v;
+                    tos = mem[sp - 1];
+                } else {
+                    uint16_t top = static_cast<uint16_t>(mem[STACK_POINTER] - 2);
+                    int16_t v = mem[top + 1];
+                    mem[TEMP_POINTER + instruction->value] = v;
+                    mem[THAT_POINTER] = mem[top];
+                    mem[top] = v;
+                    mem[STACK_POINTER] = top;
+                    mem[mem[THAT_POINTER]] = v;
+                }
+                VM_NEXT();
+            }
 
-    ram[THAT_POINTER] = ram[endFrame - 1];
-    ram[THIS_POINTER] = ram[endFrame - 2];
-    ram[ARG_POINTER]  = ram[endFrame - 3];
-    ram[LCL_POINTER]  = ram[endFrame - 4];
+            VM_HANDLER(NOT_IF_GOTO): {
+                if (maxSteps - executed < 1) {
+                    goto NOT_HANDLER;
+                }
+                executed++;
+                if constexpr (CachedStack) {
+                    int16_t condition = static_cast<int16_t>(~pop());
+                    pc = condition != 0 ? instruction->target : pc + 1;
+                } else {
+                    uint16_t top = static_cast<uint16_t>(mem[STACK_POINTER] - 1);
+                    mem[top] = ~mem[top];
+                    mem[STACK_POINTER] = top;
+                    pc = mem[top] != 0 ? instruction->target : pc + 1;
+                }
+                VM_NEXT();
+            }
 
-    program_counter = static_cast<uint16_t>(retAddr);
-}
+            VM_HANDLER(PUSH_NOT):
+                if (maxSteps - executed < 1) {
+                    goto PUSH_CONSTANT_HANDLER;
+                }
+                pc++;
+                executed++;
+                push(static_cast<int16_t>(~instruction->value));
+                VM_NEXT();
 
-void VMEmulator::stackPush(uint16_t val) {
-    uint16_t sp = ram[STACK_POINTER];
-    ram[sp] = val;
-    ram[STACK_POINTER]++;
-}
+            VM_HANDLER(DISCARD):
+                goto POP_TEMP_HANDLER;
 
-uint16_t VMEmulator::stackPop() {
-    ram[STACK_POINTER]--;
-    uint16_t sp = ram[STACK_POINTER];
-    return ram[sp];
+            case Opcode::COUNT:
+                break;
+        }
+    }
+done:
+    spill();
+    program_counter = static_cast<uint16_t>(pc);
+    stop_reason = reason;
+    peak_stack_pointer = peak;
+    if constexpr (Observer::enabled) {
+        observer.onStop(executed);
+    }
+    return executed;
 }
 
+#undef VM_NEXT
+#undef VM_HANDLER
+
 int16_t VMEmulator::peek(uint16_t addr) const {
     if (addr >= ram.size()) return 0;
     return ram[addr];
@@ -253,4 +553,4 @@ int16_t VMEmulator::peekStack() {
 
 void VMEmulator::poke(uint16_t addr, int16_t value) {
     ram[addr] = value;
-}
\ No newline at end of file
+}
@@ -1,60 +1,371 @@
 #include "Emulators/VMEmulator/VMParser.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <exception>
+#include <initializer_list>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    const char* const WHITESPACE = " \t\n\r\f\v";
+
+    struct SegmentName {
+        std::string_view name;
+        Segment segment;
+    };
+    const SegmentName SEGMENTS[] = {
+        { "local",    Segment::LOCAL },
+        { "argument", Segment::ARG },
+        { "this",     Segment::THIS },
+        { "that",     Segment::THAT },
+        { "constant", Segment::CONSTANT },
+        { "static",   Segment::STATIC },
+        { "pointer",  Segment::POINTER },
+        { "temp",     Segment::TEMP }
+    };
+
+    // Mnemonics from Opcode::ADD on
+    const char* const ARITHMETIC[] = { "add", "sub", "neg", "eq", "gt", "lt", "and", "or", "not" };
+    const uint8_t ARITHMETIC_COUNT = sizeof(ARITHMETIC) / sizeof(ARITHMETIC[0]);
+
+    // In Opcode order
+    const char* const MNEMONICS[] = {
+        "push", "push", "push", "push", "push", "push", "push", "push",
+        "pop", "pop", "pop", "pop", "pop", "pop", "pop",
+        "add", "sub", "neg", "eq", "gt", "lt", "and", "or", "not",
+        "goto", "if-goto", "call", "return",
+        "array-read", "array-write", "not-if-goto", "push-not", "discard"
+    };
+    static_assert(sizeof(MNEMONICS) / sizeof(MNEMONICS[0]) == static_cast<size_t>(Opcode::COUNT),
+                  "One mnemonic per opcode");
+
+    // Without its comment and surrounding whitespace, as a view into line
+    std::string_view trimmed(std::string_view line) {
+        line = line.substr(0, line.find("//"));
+        size_t start = line.find_first_not_of(WHITESPACE);
+        if (start == std::string_view::npos) {
+            return {};
+        }
+        size_t end = line.find_last_not_of(WHITESPACE);
+        return line.substr(start, end - start + 1);
+    }
+
+    // Next word of rest, which moves past it; empty once rest runs out
+    std::string_view nextWord(std::string_view& rest) {
+        size_t start = rest.find_first_not_of(WHITESPACE);
+        if (start == std::string_view::npos) {
+            rest = {};
+            return {};
+        }
+        size_t end = std::min(rest.find_first_of(WHITESPACE, start), rest.size());
+        std::string_view word = rest.substr(start, end - start);
+        rest.remove_prefix(end);
+        return word;
+    }
+
+    // The word's leading digits, as operator>> reads them
+    template <typename T>
+    bool readNumber(std::string_view word, T& value) {
+        return !word.empty() && std::from_chars(word.data(), word.data() + word.size(), value).ec == std::errc();
+    }
+
+    bool matches(const std::vector<VMInstruction>& code, size_t at, std::initializer_list<Opcode> sequence) {
+        if (at + sequence.size() > code.size()) {
+            return false;
+        }
+        for (Opcode op : sequence) {
+            if (code[at++].opcode != op) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
 
 void VMParser::loadFile(const std::string& filepath, SymbolTable& table) {
     std::string fileName = std::filesystem::path(filepath).stem().string();
-    table.registerFileRange(fileName, static_cast<int16_t>(instructions.size()));
+    merge(parse(fileName, FileLoader::loadText(filepath)), table);
+}
 
-    std::vector<std::string> rawLines = loader.loadRawLines(filepath);
+void VMParser::loadLines(const std::string& fileName, const std::vector<std::string>& lines, SymbolTable& table) {
+    ParsedFile file;
+    file.name = fileName;
+    for (const std::string& line : lines) {
+        parseLine(file, line);
+    }
+    merge(file, table);
+}
 
-    for (const std::string& line : rawLines) {
-        std::string cleaned = cleanLine(line);
-        
-        if (cleaned.empty()) {
-            continue;
+void VMParser::loadDirectory(const std::string& path, SymbolTable& table, size_t threads) {
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(path)) {
+        if (entry.path().extension() == ".vm") {
+            files.push_back(entry.path());
         }
+    }
+    std::sort(files.begin(), files.end(), [](const std::filesystem::path& a, const std::filesystem::path& b) {
+        return a.filename().string() < b.filename().string();
+    });
 
-        if (cleaned.rfind("label ", 0) == 0) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t workers = std::min(threads, files.size());
 
-            std::string labelName = cleaned.substr(6);
-            size_t last = labelName.find_last_not_of(" \t\n\r");
-            if (last != std::string::npos) {
-                labelName = labelName.substr(0, last + 1);
+    // Each file has its own slots, so workers share only the next index
+    std::vector<ParsedFile> parsed(files.size());
+    std::vector<std::exception_ptr> errors(files.size());
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        for (size_t i = next++; i < files.size(); i = next++) {
+            try {
+                parsed[i] = parse(files[i].stem().string(), FileLoader::loadText(files[i].string()));
+            } catch (...) {
+                errors[i] = std::current_exception();
             }
+        }
+    };
 
-            table.addLabel(fileName, labelName, static_cast<int16_t>(instructions.size()));
-        } 
-        else if (cleaned.rfind("function ", 0) == 0) {
-            std::stringstream ss(cleaned.substr(9));
-            std::string funcName;
-            int16_t locals = 0;
+    std::vector<std::thread> pool;
+    for (size_t id = 1; id < workers; id++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
 
-            if (ss >> funcName >> locals) {
-                table.addFunction(funcName, static_cast<int16_t>(instructions.size()), locals);
-            }
+    // The first bad file in filename order, whichever thread got there first
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    for (const ParsedFile& file : parsed) {
+        merge(file, table);
+    }
+}
+
+// --- Parsing ---
+
+ParsedFile VMParser::parse(const std::string& fileName, std::string_view text) {
+    ParsedFile file;
+    file.name = fileName;
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        parseLine(file, text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    }
+    return file;
+}
+
+void VMParser::parseLine(ParsedFile& file, std::string_view line) {
+    std::string_view cleaned = trimmed(line);
+    if (cleaned.empty()) {
+        return;
+    }
+
+    const uint16_t address = static_cast<uint16_t>(file.code.size());
+    std::string_view rest = cleaned;
+    std::string_view keyword = nextWord(rest);
+
+    if (keyword == "label") {
+        std::string_view labelName = nextWord(rest);
+        if (labelName.empty()) {
+            throw std::runtime_error("Invalid label: " + std::string(cleaned));
+        }
+        file.labels.push_back({ std::string(labelName), address, 0 });
+    } else if (keyword == "function") {
+        std::string_view funcName = nextWord(rest);
+        int16_t locals = 0;
+        if (funcName.empty() || !readNumber(nextWord(rest), locals)) {
+            throw std::runtime_error("Invalid function declaration: " + std::string(cleaned));
+        }
+        file.functions.push_back({ std::string(funcName), address, locals });
+    } else {
+        std::string symbol;
+        VMInstruction instruction = encode(cleaned, symbol);
+        if (!symbol.empty()) {
+            instruction.target = static_cast<uint16_t>(file.symbols.size());
+            file.symbols.push_back(std::move(symbol));
+        } else if (instruction.opcode == Opcode::PUSH_STATIC || instruction.opcode == Opcode::POP_STATIC) {
+            file.staticCount = std::max<uint16_t>(file.staticCount, instruction.value + 1);
         }
-        else {
-            instructions.push_back(cleaned);
+        file.code.push_back(instruction);
+    }
+}
+
+void VMParser::merge(const ParsedFile& file, SymbolTable& table) {
+    const uint16_t base = static_cast<uint16_t>(bytecode.size());
+    const uint16_t staticBase = staticCount;
+    table.registerFileRange(file.name, static_cast<int16_t>(base), staticBase);
+
+    for (const ParsedFile::Declaration& label : file.labels) {
+        table.addLabel(file.name, label.name, static_cast<int16_t>(base + label.address));
+    }
+    for (const ParsedFile::Declaration& function : file.functions) {
+        table.addFunction(function.name, static_cast<int16_t>(base + function.address), function.locals);
+    }
+
+    bytecode.reserve(bytecode.size() + file.code.size());
+    for (VMInstruction instruction : file.code) {
+        if (instruction.opcode == Opcode::GOTO || instruction.opcode == Opcode::IF_GOTO ||
+            instruction.opcode == Opcode::CALL) {
+            instruction.target = internSymbol(file.symbols[instruction.target]);
+        } else if (instruction.opcode == Opcode::PUSH_STATIC || instruction.opcode == Opcode::POP_STATIC) {
+            instruction.value += staticBase;
+        }
+        bytecode.push_back(instruction);
+    }
+    staticCount = staticBase + file.staticCount;
+}
+
+void VMParser::link(const SymbolTable& table) {
+    for (size_t pc = 0; pc < bytecode.size(); pc++) {
+        VMInstruction& instruction = bytecode[pc];
+        if (instruction.opcode == Opcode::GOTO || instruction.opcode == Opcode::IF_GOTO) {
+            instruction.target = table.getAddressFromLabel(static_cast<int16_t>(pc), symbols[instruction.target]);
+        } else if (instruction.opcode == Opcode::CALL) {
+            FunctionEntry entry = table.getFunctionAddress(symbols[instruction.target]);
+            instruction.target = entry.address;
+            instruction.locals = entry.numLocals;
         }
     }
 }
 
 void VMParser::clear() {
-    instructions.clear();
+    bytecode.clear();
+    symbols.clear();
+    symbolIds.clear();
+    staticCount = 0;
 }
 
-std::string VMParser::cleanLine(const std::string& line) {
-    size_t commentPos = line.find("//");
-    std::string stripped = (commentPos == std::string::npos) 
-                           ? line 
-                           : line.substr(0, commentPos);
+// --- Bytecode ---
 
-    const std::string whitespace = " \t\n\r\f\v";
-    
-    size_t start = stripped.find_first_not_of(whitespace);
-    if (start == std::string::npos) {
-        return "";
+void VMParser::addInstruction(const std::string& line) {
+    std::string symbol;
+    VMInstruction instruction = encode(line, symbol);
+    if (!symbol.empty()) {
+        instruction.target = internSymbol(symbol);
     }
+    bytecode.push_back(instruction);
+}
+
+uint16_t VMParser::internSymbol(const std::string& name) {
+    auto it = symbolIds.find(name);
+    if (it != symbolIds.end()) {
+        return it->second;
+    }
+    uint16_t id = static_cast<uint16_t>(symbols.size());
+    symbols.push_back(name);
+    symbolIds.emplace(name, id);
+    return id;
+}
 
-    size_t end = stripped.find_last_not_of(whitespace);
-    return stripped.substr(start, end - start + 1);
-}
\ No newline at end of file
+VMInstruction VMParser::encode(std::string_view line, std::string& symbol) {
+    VMInstruction instruction;
+    std::string_view rest = line;
+    std::string_view firstWord = nextWord(rest);
+    symbol.clear();
+
+    if (firstWord == "push" || firstWord == "pop") {
+        std::string_view segStr = nextWord(rest);
+        if (segStr.empty()) {
+            throw std::runtime_error("Invalid " + std::string(firstWord) + " command: " + std::string(line));
+        }
+        const SegmentName* segment = std::find_if(std::begin(SEGMENTS), std::end(SEGMENTS),
+                                                  [&](const SegmentName& s) { return segStr == s.name; });
+        if (segment == std::end(SEGMENTS)) {
+            throw std::runtime_error("Unknown segment: " + std::string(segStr));
+        }
+        instruction.segment = segment->segment;
+        // Negative indices wrap, as "push constant -1" has always meant 65535
+        int32_t index;
+        if (!readNumber(nextWord(rest), index)) {
+            throw std::runtime_error("Invalid " + std::string(firstWord) + " command: " + std::string(line));
+        }
+        instruction.value = static_cast<uint16_t>(index);
+        const uint8_t segmentIndex = static_cast<uint8_t>(instruction.segment);
+        if (firstWord == "push") {
+            instruction.opcode = static_cast<Opcode>(static_cast<uint8_t>(Opcode::PUSH_CONSTANT) + segmentIndex);
+        } else if (instruction.segment == Segment::CONSTANT) {
+            throw std::runtime_error("Cannot pop into constant segment: " + std::string(line));
+        } else {
+            instruction.opcode = static_cast<Opcode>(static_cast<uint8_t>(Opcode::POP_LOCAL) + segmentIndex - 1);
+        }
+    } else if (firstWord == "goto" || firstWord == "if-goto") {
+        instruction.opcode = (firstWord == "goto") ? Opcode::GOTO : Opcode::IF_GOTO;
+        symbol = nextWord(rest);
+        if (symbol.empty()) {
+            throw std::runtime_error("Invalid " + std::string(firstWord) + " command: " + std::string(line));
+        }
+    } else if (firstWord == "call") {
+        instruction.opcode = Opcode::CALL;
+        symbol = nextWord(rest);
+        int nArgs;
+        if (symbol.empty() || !readNumber(nextWord(rest), nArgs)) {
+            throw std::runtime_error("Invalid call command: " + std::string(line));
+        }
+        instruction.value = static_cast<uint16_t>(nArgs);
+    } else if (firstWord == "return") {
+        instruction.opcode = Opcode::RETURN;
+    } else {
+        uint8_t op = 0;
+        while (op < ARITHMETIC_COUNT && firstWord != ARITHMETIC[op]) {
+            op++;
+        }
+        if (op == ARITHMETIC_COUNT) {
+            throw std::runtime_error("Unknown VM command: " + std::string(line));
+        }
+        instruction.opcode = static_cast<Opcode>(static_cast<uint8_t>(Opcode::ADD) + op);
+    }
+    return instruction;
+}
+
+// --- Superinstructions ---
+
+std::vector<VMInstruction> VMParser::fuse(const std::vector<VMInstruction>& code) {
+    std::vector<VMInstruction> fused = code;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (matches(code, i, { Opcode::POP_TEMP, Opcode::POP_POINTER, Opcode::PUSH_TEMP, Opcode::POP_THAT }) &&
+            code[i + 1].value == 1 && code[i + 2].value == code[i].value && code[i + 3].value == 0) {
+            fused[i].opcode = Opcode::ARRAY_WRITE;
+        } else if (matches(code, i, { Opcode::ADD, Opcode::POP_POINTER, Opcode::PUSH_THAT }) &&
+                   code[i + 1].value == 1 && code[i + 2].value == 0) {
+            fused[i].opcode = Opcode::ARRAY_READ;
+        } else if (matches(code, i, { Opcode::NOT, Opcode::IF_GOTO })) {
+            fused[i].opcode = Opcode::NOT_IF_GOTO;
+            fused[i].target = code[i + 1].target;
+        } else if (matches(code, i, { Opcode::PUSH_CONSTANT, Opcode::NOT })) {
+            fused[i].opcode = Opcode::PUSH_NOT;
+        } else if (i > 0 && code[i - 1].opcode == Opcode::CALL && code[i].opcode == Opcode::POP_TEMP) {
+            fused[i].opcode = Opcode::DISCARD;
+        }
+    }
+    return fused;
+}
+
+const char* VMParser::mnemonic(Opcode op) {
+    return MNEMONICS[static_cast<uint8_t>(op)];
+}
+
+InstructionType VMParser::typeOf(Opcode op) {
+    switch (op) {
+        case Opcode::NEG:
+        case Opcode::NOT:     return InstructionType::UNARY_ARITHMETIC;
+        case Opcode::GOTO:    return InstructionType::GOTO;
+        case Opcode::IF_GOTO: return InstructionType::IF_GOTO;
+        case Opcode::CALL:    return InstructionType::FUNCTION_CALL;
+        case Opcode::RETURN:  return InstructionType::RETURN;
+        default:
+            if (op < Opcode::POP_LOCAL) {
+                return InstructionType::PUSH;
+            }
+            return op < Opcode::ADD ? InstructionType::POP : InstructionType::BINARY_ARITHMETIC;
+    }
+}
+
+std::string VMParser::cleanLine(const std::string& line) {
+    return std::string(trimmed(line));
+}
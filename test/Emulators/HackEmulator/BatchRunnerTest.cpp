@@ -0,0 +1,97 @@
+#include <catch2/catch_test_macros.hpp>
+#include "Emulators/HackEmulator/BatchRunner.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const std::string TWO_OUTPUTS_DIR = "../test/Emulators/HackEmulator/TestFiles/TwoOutputs";
+
+    // Copy of the TwoOutputs script in a temp directory with its own .cmp
+    std::string scriptWithCmp(const std::string& cmp) {
+        fs::path dir = fs::temp_directory_path() / "batch_runner_test";
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        for (const char* file : { "TwoOutputs.tst", "TwoOutputs.hack" }) {
+            fs::copy_file(fs::path(TWO_OUTPUTS_DIR) / file, dir / file);
+        }
+        std::ofstream(dir / "TwoOutputs.cmp") << cmp;
+        return (dir / "TwoOutputs.tst").string();
+    }
+
+    // A script of its own next to the TwoOutputs program
+    std::string customScript(const std::string& tst, const std::string& cmp) {
+        std::string path = scriptWithCmp(cmp);
+        std::ofstream(path) << "load TwoOutputs.asm,\n" << tst;
+        return path;
+    }
+}
+
+TEST_CASE("Batch runner checks each output where the script makes it", "[HackEmulator][Batch]") {
+    BatchJob job = BatchRunner::loadTestScript(TWO_OUTPUTS_DIR + "/TwoOutputs.tst");
+    REQUIRE(job.steps.size() == 2);
+    REQUIRE(job.steps[0].setRam.size() == 1);
+    REQUIRE(job.steps[0].cycles == 12);
+    REQUIRE(job.steps[0].checks.size() == 1);
+    REQUIRE(job.steps[0].checks[0].address == 101);
+    REQUIRE(job.steps[0].checks[0].expected == 8);
+    REQUIRE(job.steps[1].setRam[0].second == 41);
+    REQUIRE(job.steps[1].cycles == 13);
+    REQUIRE(job.steps[1].checks.size() == 2);
+
+    // RAM[101] is 8 only until RAM[100] changes, so the first output has to
+    // be checked before the second step runs
+    std::vector<BatchResult> results = BatchRunner(1).run({ job });
+    INFO((results[0].failures.empty() ? "" : results[0].failures.front()));
+    REQUIRE(results[0].passed);
+    REQUIRE(results[0].run.cycles == 25);
+
+    SECTION("A wrong value in the second row fails") {
+        BatchJob wrong = BatchRunner::loadTestScript(
+            scriptWithCmp("|RAM[101]|\n|     8  |\n|RAM[100]|RAM[101]|\n|    41  |    43  |\n"));
+        BatchResult result = BatchRunner(1).run({ wrong })[0];
+        REQUIRE_FALSE(result.passed);
+        REQUIRE(result.failures == std::vector<std::string>{ "Output 2: RAM[101] expected 43, got 42" });
+    }
+
+    SECTION("Rows must match the outputs") {
+        REQUIRE_THROWS(BatchRunner::loadTestScript(scriptWithCmp("|RAM[101]|\n|     8  |\n")));
+        REQUIRE_THROWS(BatchRunner::loadTestScript(
+            scriptWithCmp("|RAM[101]|\n|     8  |\n|RAM[101]|RAM[100]|\n|    42  |    41  |\n")));
+        REQUIRE_THROWS(BatchRunner::loadTestScript(
+            scriptWithCmp("|RAM[101]|\n|     8  |\n|RAM[100]|RAM[101]|\n|    41  |    42  |\n|    41  |    42  |\n")));
+    }
+}
+
+TEST_CASE("Batch runner runs repeat blocks command by command", "[HackEmulator][Batch]") {
+    const std::string oneRow = "|RAM[101]|\n|     8  |\n";
+
+    SECTION("Every ticktock in the block counts") {
+        BatchJob job = BatchRunner::loadTestScript(customScript(
+            "set RAM[100] 7,\nrepeat 3 {\n  ticktock;\n  ticktock;\n}\noutput-list RAM[101]%D1.6.1;\noutput;\n", oneRow));
+        REQUIRE(job.steps.size() == 1);
+        REQUIRE(job.steps[0].cycles == 6);
+    }
+
+    SECTION("Outputs and sets inside a block happen on every pass") {
+        BatchJob job = BatchRunner::loadTestScript(customScript(
+            "output-list RAM[101]%D1.6.1;\nrepeat 2 {\n  set RAM[100] 7,\n  repeat 12 { ticktock; }\n  output;\n}\n",
+            "|RAM[101]|\n|     8  |\n|     8  |\n"));
+        REQUIRE(job.steps.size() == 2);
+        for (const BatchStep& step : job.steps) {
+            REQUIRE(step.setRam.size() == 1);
+            REQUIRE(step.cycles == 12);
+            REQUIRE(step.checks.size() == 1);
+        }
+    }
+
+    SECTION("Unsupported commands and broken blocks throw") {
+        const std::string tail = "output-list RAM[101]%D1.6.1;\noutput;\n";
+        REQUIRE_THROWS(BatchRunner::loadTestScript(customScript("echo \"hi\",\n" + tail, oneRow)));
+        REQUIRE_THROWS(BatchRunner::loadTestScript(customScript("set PC 0,\n" + tail, oneRow)));
+        REQUIRE_THROWS(BatchRunner::loadTestScript(customScript("repeat 3,\nticktock;\n" + tail, oneRow)));
+        REQUIRE_THROWS(BatchRunner::loadTestScript(customScript("repeat 3 {\nticktock;\n" + tail, oneRow)));
+        REQUIRE_THROWS(BatchRunner::loadTestScript(customScript("ticktock;\n}\n" + tail, oneRow)));
+    }
+}
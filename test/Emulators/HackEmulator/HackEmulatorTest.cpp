@@ -1,9 +1,22 @@
 #include <catch2/catch_test_macros.hpp>
 #include "Emulators/FileLoader.hpp" // Required for FileLoader (if used in other tests)
 #include "Emulators/HackEmulator/HackEmulator.hpp" // The class under test
+#include "Emulators/HackEmulator/ExecutionProfiler.hpp"
+#include "Emulators/HackEmulator/InstructionMix.hpp"
+#include "Emulators/HackEmulator/ScreenRecorder.hpp"
+#include "Emulators/HackEmulator/ExecutionTracer.hpp"
+#include "Emulators/HackEmulator/NativeTranslator.hpp"
+#include "Emulators/HackEmulator/WideHackEmulator.hpp"
+#include "Emulators/HackEmulator/KeyboardInput.hpp"
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
 #include <vector>
 #include <cstdint>
 
+namespace fs = std::filesystem;
+
 int16_t to_hack_instruction(int input) {
     return static_cast<int16_t>(input);
 }
@@ -74,6 +87,35 @@ TEST_CASE("HackEmulator decodes instructions correctly", "[HackEmulator][Decode]
     REQUIRE(instr.comp_code == 0b000000);
 }
 
+TEST_CASE("HackEmulator predecodes ROM into micro-ops on load", "[HackEmulator][Predecode]") {
+    HackEmulator emu;
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0000000000000111), // @7
+        to_hack_instruction(0b1111110010011000), // MD=M-1
+        to_hack_instruction(0b1110001100000101), // D;JNE
+        to_hack_instruction(0b1110100000000000)  // invalid comp
+    };
+    emu.loadProgram(commands);
+
+    MicroOp op = emu.getMicroOp(0);
+    REQUIRE(op.alu == AluOp::LOAD_A);
+    REQUIRE(op.value == 7);
+
+    op = emu.getMicroOp(1);
+    REQUIRE(op.alu == AluOp::M_MINUS_ONE);
+    REQUIRE(op.control == (HackEmulator::DEST_M | HackEmulator::DEST_D));
+
+    op = emu.getMicroOp(2);
+    REQUIRE(op.alu == AluOp::D);
+    REQUIRE(op.control == (HackEmulator::JUMP_GT | HackEmulator::JUMP_LT));
+
+    REQUIRE(emu.getMicroOp(3).alu == AluOp::INVALID);
+    REQUIRE(emu.getMicroOp(4).alu == AluOp::LOAD_A); // Unused ROM is @0
+
+    emu.setPC(3);
+    REQUIRE_THROWS_AS(emu.executeNextInstruction(), std::runtime_error);
+}
+
 TEST_CASE("HackEmulator executes single instructions correctly", "[HackEmulator][Execute]") {
     HackEmulator emu;
 
@@ -402,4 +444,626 @@ TEST_CASE("HackEmulator: Comprehensive Jump Logic (D-register result)", "[HackEm
         // D = -5 (< 0) -> Jump Taken
         execute_jump_test(emu, -5, JUMP_BITS, TARGET, TARGET); 
     }
-}
\ No newline at end of file
+}
+TEST_CASE("HackEmulator: Batched run loop", "[HackEmulator][Run]") {
+    HackEmulator emu;
+    // Counts RAM[0] up forever
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1111110111001000), // M=M+1
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    emu.loadProgram(commands);
+
+    SECTION("run stops after the cycle budget") {
+        RunResult result = emu.run(10);
+        REQUIRE(result.cycles == 10);
+        REQUIRE(result.reason == StopReason::CYCLE_LIMIT);
+        REQUIRE(result.pc == 2);
+        REQUIRE(emu.peek(0) == 3);
+        REQUIRE(emu.getCycleCount() == 10);
+    }
+
+    SECTION("runUntil stops when the PC is reached") {
+        RunResult result = emu.runUntil(3, 100);
+        REQUIRE(result.cycles == 3);
+        REQUIRE(result.reason == StopReason::BREAKPOINT);
+        REQUIRE(result.pc == 3);
+
+        result = emu.runUntil(3, 100);
+        REQUIRE(result.cycles == 4);
+        REQUIRE(emu.peek(0) == 2);
+        REQUIRE(emu.getCycleCount() == 7);
+    }
+
+    SECTION("runUntil stops when the predicate holds") {
+        RunResult result = emu.runUntil([](const HackEmulator& e) { return e.peek(0) == 5; }, 1000);
+        REQUIRE(result.reason == StopReason::PREDICATE);
+        REQUIRE(result.cycles == 18);
+        REQUIRE(result.pc == 2);
+    }
+}
+
+TEST_CASE("HackEmulator: Halt loop detection", "[HackEmulator][Halt]") {
+    HackEmulator emu;
+
+    SECTION("(END) @END 0;JMP halts") {
+        std::vector<int16_t> commands = {
+            to_hack_instruction(0b0000000000000111), // @7
+            to_hack_instruction(0b1110110000010000), // D=A
+            to_hack_instruction(0b0000000000000010), // (END) @2
+            to_hack_instruction(0b1110101010000111)  // 0;JMP
+        };
+        emu.loadProgram(commands);
+        RunResult result = emu.run(1000000);
+        REQUIRE(result.reason == StopReason::HALTED);
+        REQUIRE(result.cycles < 100);
+        REQUIRE(result.pc == 2);
+        REQUIRE(emu.getDRegister() == 7);
+
+        // Running again stops straight away
+        result = emu.run(1000000);
+        REQUIRE(result.reason == StopReason::HALTED);
+        REQUIRE(result.cycles == 2);
+    }
+
+    SECTION("Loops that rewrite RAM with the same values halt") {
+        std::vector<int16_t> commands = {
+            to_hack_instruction(0b0000000000000101), // (LOOP) @5
+            to_hack_instruction(0b1110111111001000), // M=1
+            to_hack_instruction(0b1111110000010000), // D=M
+            to_hack_instruction(0b0000000000000000), // @LOOP
+            to_hack_instruction(0b1110001100000101)  // D;JNE
+        };
+        emu.loadProgram(commands);
+        RunResult result = emu.run(1000000);
+        REQUIRE(result.reason == StopReason::HALTED);
+        REQUIRE(result.pc == 0);
+        REQUIRE(emu.peek(5) == 1);
+    }
+
+    SECTION("Loops that make progress keep running") {
+        std::vector<int16_t> commands = {
+            to_hack_instruction(0b0000000000000000), // @0
+            to_hack_instruction(0b1111110111001000), // M=M+1
+            to_hack_instruction(0b0000000000000000), // @0
+            to_hack_instruction(0b1110101010000111)  // 0;JMP
+        };
+        emu.loadProgram(commands);
+        RunResult result = emu.run(100000);
+        REQUIRE(result.reason == StopReason::CYCLE_LIMIT);
+        REQUIRE(emu.peek(0) == 25000);
+    }
+
+    SECTION("Breakpoints inside the loop and disabled detection keep running") {
+        std::vector<int16_t> commands = {
+            to_hack_instruction(0b0000000000000000), // (END) @0
+            to_hack_instruction(0b1110101010000111)  // 0;JMP
+        };
+        emu.loadProgram(commands);
+        REQUIRE(emu.runUntil(1, 1000).reason == StopReason::BREAKPOINT);
+        REQUIRE(emu.runUntil(1, 1000).reason == StopReason::BREAKPOINT);
+
+        emu.setHaltDetection(false);
+        REQUIRE(emu.run(1000).reason == StopReason::CYCLE_LIMIT);
+    }
+}
+
+TEST_CASE("HackEmulator: Loop acceleration", "[HackEmulator][LoopAcceleration]") {
+    // RAM[0] = 1000, then counts it down to 0
+    std::vector<int16_t> countdown = {
+        to_hack_instruction(0b0000001111101000), // @1000
+        to_hack_instruction(0b1110110000010000), // D=A
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1110001100001000), // M=D
+        to_hack_instruction(0b0000000000000000), // (LOOP) @0
+        to_hack_instruction(0b1111110010001000), // M=M-1
+        to_hack_instruction(0b1111110000010000), // D=M
+        to_hack_instruction(0b0000000000000100), // @LOOP
+        to_hack_instruction(0b1110001100000001), // D;JGT
+        to_hack_instruction(0b0000000000001001), // (END) @END
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    HackEmulator plain;
+    HackEmulator fast;
+    plain.loadProgram(countdown);
+    fast.loadProgram(countdown);
+    fast.setLoopAcceleration(true);
+
+    auto sameState = [&]() {
+        REQUIRE(fast.getCycleCount() == plain.getCycleCount());
+        REQUIRE(fast.getPC() == plain.getPC());
+        REQUIRE(fast.getARegister() == plain.getARegister());
+        REQUIRE(fast.getDRegister() == plain.getDRegister());
+        REQUIRE(fast.peek(0) == plain.peek(0));
+    };
+
+    SECTION("Countdowns are skipped exactly") {
+        RunResult slow = plain.runUntil(9, 100000);
+        RunResult skipped = fast.runUntil(9, 100000);
+        REQUIRE(skipped.reason == StopReason::BREAKPOINT);
+        REQUIRE(skipped.cycles == slow.cycles);
+        REQUIRE(fast.peek(0) == 0);
+        sameState();
+        REQUIRE(fast.getAcceleratedCycles() > 4500);
+
+        // The END loop changes nothing, so it is still reported as halted
+        REQUIRE(fast.run(100000).reason == StopReason::HALTED);
+    }
+
+    SECTION("A budget ending inside the loop stops on the same cycle") {
+        for (uint64_t budget : { 37, 1234, 2999 }) {
+            plain.run(budget);
+            fast.run(budget);
+            sameState();
+        }
+        REQUIRE(fast.getAcceleratedCycles() > 0);
+    }
+
+    SECTION("Block cache runs skip too") {
+        fast.setExecutionMode(ExecutionMode::BLOCK_CACHE);
+        plain.runUntil(9, 100000);
+        fast.runUntil(9, 100000);
+        sameState();
+        REQUIRE(fast.getAcceleratedCycles() > 0);
+    }
+
+    SECTION("Loops that do not step by a constant run normally") {
+        std::vector<int16_t> doubling = {
+            to_hack_instruction(0b0000000000000000), // (LOOP) @0
+            to_hack_instruction(0b1111110000010000), // D=M
+            to_hack_instruction(0b1111000010001000), // M=D+M
+            to_hack_instruction(0b0000000000000000), // @LOOP
+            to_hack_instruction(0b1110101010000111)  // 0;JMP
+        };
+        plain.loadProgram(doubling);
+        fast.loadProgram(doubling);
+        plain.setRamValue(0, 1);
+        fast.setRamValue(0, 1);
+        plain.run(5000);
+        fast.run(5000);
+        sameState();
+        REQUIRE(fast.getAcceleratedCycles() == 0);
+    }
+}
+
+TEST_CASE("HackEmulator: Strict and fast memory modes", "[HackEmulator][MemoryMode]") {
+    HackEmulator emu;
+    // @32769, M=1
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0111111111111111), // @32767
+        to_hack_instruction(0b1110110111100000), // A=A+1
+        to_hack_instruction(0b1110110111100000), // A=A+1
+        to_hack_instruction(0b1110111111001000)  // M=1
+    };
+    emu.loadProgram(commands);
+    REQUIRE(emu.getMemoryMode() == MemoryMode::STRICT);
+
+    SECTION("Strict mode throws on addresses past the keyboard") {
+        emu.run(3);
+        REQUIRE_THROWS_AS(emu.run(1), std::out_of_range);
+    }
+
+    SECTION("Fast mode masks addresses into 32K") {
+        emu.setMemoryMode(MemoryMode::FAST);
+        emu.run(4);
+        REQUIRE(emu.getARegister() == -32767);
+        REQUIRE(emu.peek(1) == 1);
+    }
+}
+
+TEST_CASE("HackEmulator: Execution profiler counts", "[HackEmulator][Profiler]") {
+    HackEmulator emu;
+    // Counts RAM[0] up forever
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1111110111001000), // M=M+1
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    emu.loadProgram(commands);
+
+    ExecutionProfiler profiler;
+    RunResult result = emu.run(10, profiler);
+    REQUIRE(result.cycles == 10);
+    REQUIRE(profiler.getTotalExecutions() == 10);
+    REQUIRE(profiler.getExecutions(0) == 3);
+    REQUIRE(profiler.getExecutions(1) == 3);
+    REQUIRE(profiler.getExecutions(3) == 2);
+    REQUIRE(profiler.getReads(0) == 3);
+    REQUIRE(profiler.getWrites(0) == 3);
+
+    result = emu.runUntil(1, 100, profiler);
+    REQUIRE(result.reason == StopReason::BREAKPOINT);
+    REQUIRE(profiler.getExecutions(3) == 3);
+    REQUIRE(emu.getCycleCount() == 13);
+}
+
+TEST_CASE("HackEmulator: Instruction mix counts", "[HackEmulator][InstructionMix]") {
+    HackEmulator emu;
+    // RAM[0] = 3, then counts it down to 0
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0000000000000011), // @3
+        to_hack_instruction(0b1110110000010000), // D=A
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1110001100001000), // M=D
+        to_hack_instruction(0b0000000000000000), // (LOOP) @0
+        to_hack_instruction(0b1111110010001000), // M=M-1
+        to_hack_instruction(0b1111110000010000), // D=M
+        to_hack_instruction(0b0000000000000100), // @LOOP
+        to_hack_instruction(0b1110001100000001), // D;JGT
+        to_hack_instruction(0b0000000000001001), // (END) @END
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    emu.loadProgram(commands);
+
+    InstructionMix mix;
+    REQUIRE(emu.runUntil(9, 100, mix).cycles == 19);
+
+    InstructionMixSummary summary = mix.summarize(emu);
+    REQUIRE(summary.instructions == 19);
+    REQUIRE(summary.a_instructions == 8);
+    REQUIRE(summary.a_unclassified == 8);
+    REQUIRE(summary.c_instructions == 11);
+    REQUIRE(summary.comp == std::map<std::string, uint64_t>{ { "A", 1 }, { "D", 4 }, { "M", 3 }, { "M-1", 3 } });
+    REQUIRE(summary.dest == std::map<std::string, uint64_t>{ { "D", 4 }, { "M", 4 }, { "null", 3 } });
+    REQUIRE(summary.jump == std::map<std::string, uint64_t>{ { "JGT", 3 }, { "null", 8 } });
+    REQUIRE(summary.jump_taken.at("JGT") == 2);
+    REQUIRE(summary.branches_taken == 2);
+    REQUIRE(summary.branches_not_taken == 1);
+
+    // The END loop jumps unconditionally and is not a branch
+    emu.run(4, mix);
+    summary = mix.summarize(emu);
+    REQUIRE(summary.jump_taken.at("JMP") == 2);
+    REQUIRE(summary.branches_taken == 2);
+
+    std::ostringstream json;
+    InstructionMix::writeJson(json, summary);
+    REQUIRE(json.str().find("\"instructions\": 23,") != std::string::npos);
+    REQUIRE(json.str().find("\"jump\": {\"JGT\": 3, \"JMP\": 2, \"null\": 8}") != std::string::npos);
+    REQUIRE(json.str().find("\"branches\": {\"taken\": 2, \"not_taken\": 1}") != std::string::npos);
+
+    mix.reset();
+    REQUIRE(mix.summarize(emu).instructions == 0);
+    REQUIRE(InstructionMix::destMnemonic(HackEmulator::DEST_A | HackEmulator::DEST_M | HackEmulator::DEST_D) == "AMD");
+}
+
+TEST_CASE("HackEmulator: Trace ring buffer", "[HackEmulator][Trace]") {
+    TraceRingBuffer<int> ring(5);
+    REQUIRE(ring.capacity() == 8);
+    for (int i = 0; i < 8; i++) {
+        REQUIRE(ring.tryPush(i));
+    }
+    REQUIRE_FALSE(ring.tryPush(8));
+
+    int out[8];
+    REQUIRE(ring.popBatch(out, 3) == 3);
+    REQUIRE(out[0] == 0);
+    REQUIRE(out[2] == 2);
+    REQUIRE(ring.tryPush(8));
+    REQUIRE(ring.size() == 6);
+
+    // Overwriting keeps the newest items
+    for (int i = 9; i < 12; i++) {
+        ring.pushOverwrite(i);
+    }
+    REQUIRE(ring.popBatch(out, 8) == 8);
+    REQUIRE(out[0] == 4);
+    REQUIRE(out[7] == 11);
+    REQUIRE(ring.popBatch(out, 8) == 0);
+}
+
+TEST_CASE("HackEmulator: Execution tracer records", "[HackEmulator][Trace]") {
+    HackEmulator emu;
+    // Counts RAM[0] up forever
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1111110111011000), // MD=M+1
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    emu.loadProgram(commands);
+
+    ExecutionTracer tracer(4);
+    RunResult result = emu.run(11, tracer);
+    REQUIRE(result.cycles == 11);
+
+    // Only the last 4 instructions are kept: 0;JMP @0 MD=M+1 @0
+    std::vector<TraceRecord> records = tracer.drain();
+    REQUIRE(records.size() == 4);
+    REQUIRE(records[0].pc == 3);
+    REQUIRE(records[1].pc == 0);
+    REQUIRE(records[1].flags == 0);
+    REQUIRE(records[2].pc == 1);
+    REQUIRE(records[2].flags == ExecutionTracer::WROTE_M);
+    REQUIRE(records[2].m_address == 0);
+    REQUIRE(records[2].m_value == 3);
+    REQUIRE(records[2].d_register == 3);
+    REQUIRE(records[3].pc == 2);
+    REQUIRE(tracer.drain().empty());
+
+    // A rejected tracer leaves the file untouched
+    const fs::path path = fs::temp_directory_path() / "HackEmulator_unused.trace";
+    std::ofstream(path) << "keep";
+    REQUIRE_THROWS_AS(TraceWriter(tracer, path.string()), std::invalid_argument);
+    REQUIRE(fs::file_size(path) == 4);
+    fs::remove(path);
+}
+
+TEST_CASE("HackEmulator: Native translator blocks", "[HackEmulator][Native]") {
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1111110111001000), // M=M+1
+        to_hack_instruction(0b1111110000010000), // D=M
+        to_hack_instruction(0b0000000000000101), // @5
+        to_hack_instruction(0b1110001100000101), // D;JNE
+        to_hack_instruction(0b0000000000000101), // (END) @5
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    NativeTranslator translator(commands, "hack_native_test");
+    REQUIRE(translator.getBlockCount() == 2);
+
+    std::ostringstream out;
+    translator.write(out);
+    const std::string code = out.str();
+    REQUIRE(code.find("uint64_t hack_native_test(") != std::string::npos);
+    // The jump to END is static and END is fast-forwarded as a halt loop
+    REQUIRE(code.find("if (r != 0) goto B_5;") != std::string::npos);
+    REQUIRE(code.find("pc = ((maxCycles - cycles) & 1) ? 6 : 5;") != std::string::npos);
+}
+
+TEST_CASE("HackEmulator: Wide emulator lanes diverge and halt", "[HackEmulator][Wide]") {
+    // Counts RAM[1] up to RAM[0], then halts
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0000000000000001), // (LOOP) @1
+        to_hack_instruction(0b1111110000010000), // D=M
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1111010011010000), // D=D-M
+        to_hack_instruction(0b0000000000001010), // @END
+        to_hack_instruction(0b1110001100000010), // D;JEQ
+        to_hack_instruction(0b0000000000000001), // @1
+        to_hack_instruction(0b1111110111001000), // M=M+1
+        to_hack_instruction(0b0000000000000000), // @LOOP
+        to_hack_instruction(0b1110101010000111), // 0;JMP
+        to_hack_instruction(0b0000000000001010), // (END) @END
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    WideHackEmulator<8> wide;
+    wide.loadProgram(commands);
+    for (size_t lane = 0; lane < 8; lane++) {
+        wide.setRamValue(lane, 0, static_cast<int16_t>(lane * 3));
+    }
+
+    std::array<RunResult, 8> results = wide.run(1000);
+    for (size_t lane = 0; lane < 8; lane++) {
+        REQUIRE(results[lane].reason == StopReason::HALTED);
+        REQUIRE(results[lane].pc == 10);
+        REQUIRE(results[lane].cycles == 6 + lane * 3 * 10);
+        REQUIRE(wide.peek(lane, 1) == static_cast<int16_t>(lane * 3));
+    }
+    // Lanes leaving the loop early never hold the others back
+    REQUIRE(wide.getStepCount() == wide.getCycleCount(7));
+
+    // An unbounded budget returns as soon as every lane has halted
+    wide.reset();
+    for (size_t lane = 0; lane < 8; lane++) {
+        wide.setRamValue(lane, 0, static_cast<int16_t>(lane * 3));
+    }
+    results = wide.run(std::numeric_limits<uint64_t>::max());
+    for (size_t lane = 0; lane < 8; lane++) {
+        REQUIRE(results[lane].reason == StopReason::HALTED);
+        REQUIRE(results[lane].cycles == 6 + lane * 3 * 10);
+    }
+
+    // A budget stops each lane on its own cycle count
+    wide.reset();
+    wide.setRamValue(0, 100);
+    results = wide.run(25);
+    for (size_t lane = 0; lane < 8; lane++) {
+        REQUIRE(results[lane].reason == StopReason::CYCLE_LIMIT);
+        REQUIRE(results[lane].cycles == 25);
+        REQUIRE(wide.peek(lane, 1) == 2);
+    }
+    REQUIRE(wide.getStepCount() == 25);
+    REQUIRE_THROWS_AS(wide.peek(8, 0), std::out_of_range);
+}
+
+TEST_CASE("HackEmulator: Keyboard events and replay", "[HackEmulator][Keyboard]") {
+    // Waits for a key, copies it to RAM[0], then halts
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0110000000000000), // (WAIT) @KBD
+        to_hack_instruction(0b1111110000010000), // D=M
+        to_hack_instruction(0b0000000000000000), // @WAIT
+        to_hack_instruction(0b1110001100000010), // D;JEQ
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1110001100001000), // M=D
+        to_hack_instruction(0b0000000000000110), // (END) @END
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    HackEmulator emu;
+    emu.loadProgram(commands);
+
+    SECTION("Polling with no input looks halted") {
+        RunResult result = emu.run(100000);
+        REQUIRE(result.reason == StopReason::HALTED);
+        REQUIRE(result.pc < 4);
+    }
+
+    SECTION("A pending event keeps the program running until it arrives") {
+        KeyboardInput input;
+        input.schedule(100000, 75);
+        emu.setKeyboardInput(&input);
+
+        // The budget ends before the event, and halt detection stays quiet
+        RunResult result = emu.run(60000);
+        REQUIRE(result.reason == StopReason::CYCLE_LIMIT);
+        REQUIRE(result.cycles == 60000);
+        REQUIRE(emu.peek(HackEmulator::KBD_ADDRESS) == 0);
+
+        result = emu.runUntil(6, 100000);
+        REQUIRE(result.reason == StopReason::BREAKPOINT);
+        REQUIRE(emu.getCycleCount() == 100006);
+        REQUIRE(emu.peek(0) == 75);
+        REQUIRE_FALSE(input.hasPending());
+
+        // Nothing left to wait for, so the END loop is detected again
+        REQUIRE(emu.run(100000).reason == StopReason::HALTED);
+        REQUIRE(input.getRecording() == std::vector<KeyEvent>{ { 100000, 75 } });
+    }
+
+    SECTION("Live key presses are recorded and replay identically") {
+        KeyboardInput live;
+        emu.setKeyboardInput(&live);
+        emu.setHaltDetection(false);
+        emu.run(4001);
+        emu.pressKey(32);
+        emu.run(20);
+        emu.pressKey(0);
+        REQUIRE(emu.peek(0) == 32);
+        REQUIRE(live.getRecording() == std::vector<KeyEvent>{ { 4001, 32 }, { 4021, 0 } });
+
+        const fs::path path = fs::temp_directory_path() / "keyboard_test.keys";
+        live.save(path.string());
+        KeyboardInput replay = KeyboardInput::load(path.string());
+        fs::remove(path);
+        REQUIRE(replay.getPendingCount() == 2);
+
+        HackEmulator other;
+        other.loadProgram(commands);
+        other.setKeyboardInput(&replay);
+        other.run(4021);
+        REQUIRE(other.peek(0) == 32);
+        REQUIRE(other.getPC() == emu.getPC());
+        REQUIRE(other.peek(HackEmulator::KBD_ADDRESS) == 32);
+        other.run(0);
+        REQUIRE(other.peek(HackEmulator::KBD_ADDRESS) == 0);
+        REQUIRE(replay.getRecording() == live.getRecording());
+    }
+
+    SECTION("Bad events are rejected") {
+        KeyboardInput input;
+        REQUIRE_THROWS_AS(input.schedule(10, -1), std::invalid_argument);
+
+        const fs::path path = fs::temp_directory_path() / "keyboard_bad.keys";
+        std::ofstream(path) << "# comment\n20 1\n10 2\n";
+        REQUIRE_THROWS_AS(KeyboardInput::load(path.string()), std::runtime_error);
+        fs::remove(path);
+        REQUIRE_THROWS_AS(KeyboardInput::load(path.string()), std::runtime_error);
+    }
+}
+
+TEST_CASE("HackEmulator: Snapshot and restore", "[HackEmulator][Snapshot]") {
+    HackEmulator emu;
+    // Counts RAM[0] up forever
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1111110111001000), // M=M+1
+        to_hack_instruction(0b0000000000000000), // @0
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    emu.loadProgram(commands);
+    emu.setRamValue(20000, 42);
+    emu.run(6);
+
+    HackSnapshot booted = emu.snapshot();
+    REQUIRE(emu.getDirtyPageCount() == 0);
+
+    emu.run(40);
+    emu.setRamValue(16384, -1);
+    REQUIRE(emu.getDirtyPageCount() == 2);
+    REQUIRE(emu.peek(0) == 12);
+
+    SECTION("Restoring copies only dirty pages and brings back registers") {
+        emu.restore(booted);
+        REQUIRE(emu.getDirtyPageCount() == 0);
+        REQUIRE(emu.peek(0) == 2);
+        REQUIRE(emu.peek(16384) == 0);
+        REQUIRE(emu.peek(20000) == 42);
+        REQUIRE(emu.getPC() == 2);
+        REQUIRE(emu.getARegister() == 0);
+        REQUIRE(emu.getCycleCount() == 6);
+
+        // Restoring again after more work gives the same machine
+        emu.run(40);
+        emu.restore(booted);
+        REQUIRE(emu.peek(0) == 2);
+        REQUIRE(emu.getCycleCount() == 6);
+    }
+
+    SECTION("Snapshots from another emulator are copied in full") {
+        HackEmulator other;
+        other.loadProgram(commands);
+        other.restore(booted);
+        REQUIRE(other.peek(0) == 2);
+        REQUIRE(other.peek(20000) == 42);
+        REQUIRE(other.getPC() == 2);
+
+        HackSnapshot empty;
+        REQUIRE_THROWS_AS(other.restore(empty), std::invalid_argument);
+    }
+}
+
+TEST_CASE("HackEmulator: Screen recorder re-encodes dirty rows", "[HackEmulator][Screen]") {
+    HackEmulator emu;
+    // RAM[16384] = 1 (top-left pixel), RAM[24575] = -32768 (bottom-right pixel), then halt
+    std::vector<int16_t> commands = {
+        to_hack_instruction(0b0100000000000000), // @16384
+        to_hack_instruction(0b1110111111001000), // M=1
+        to_hack_instruction(0b1110110000010000), // D=A
+        to_hack_instruction(0b1110000010010000), // D=D+A
+        to_hack_instruction(0b0101111111111111), // @24575
+        to_hack_instruction(0b1110001100001000), // M=D
+        to_hack_instruction(0b0000000000000110), // (END) @6
+        to_hack_instruction(0b1110101010000111)  // 0;JMP
+    };
+    emu.loadProgram(commands);
+
+    const fs::path dir = fs::temp_directory_path() / "screen_recorder_test";
+    fs::remove_all(dir);
+    ScreenRecorder pbm((dir / "pbm").string(), FrameFormat::PBM, 2);
+    pbm.captureFrame(emu);
+    REQUIRE(pbm.getLastDirtyRowCount() == 256);
+
+    RunResult result = pbm.run(emu, 1000);
+    REQUIRE(result.reason == StopReason::HALTED);
+    const std::vector<uint8_t>& frame = pbm.getFrame();
+    const size_t header = std::string("P4\n512 256\n").size();
+    REQUIRE(frame.size() == header + 64 * 256);
+    REQUIRE(frame[header] == 0x80);
+    REQUIRE(frame[header + 1] == 0x00);
+    REQUIRE(frame.back() == 0x01);
+    REQUIRE(pbm.getFrameCount() > 2);
+    REQUIRE(pbm.getLastDirtyRowCount() == 0);
+
+    std::ifstream written(dir / "pbm" / "frame_000001.pbm", std::ios::binary);
+    REQUIRE(written.is_open());
+    std::string magic;
+    written >> magic;
+    REQUIRE(magic == "P4");
+
+    SECTION("PPM frames are black on white") {
+        HackEmulator other;
+        other.loadProgram(commands);
+        ScreenRecorder ppm((dir / "ppm").string(), FrameFormat::PPM, 1000);
+        ppm.run(other, 1000);
+        const size_t ppmHeader = std::string("P6\n512 256\n255\n").size();
+        REQUIRE(ppm.getFrame()[ppmHeader] == 0);
+        REQUIRE(ppm.getFrame()[ppmHeader + 3] == 255);
+    }
+
+    SECTION("A frame that cannot be written throws") {
+        if (fs::exists("/dev/full")) {
+            ScreenRecorder full((dir / "full").string(), FrameFormat::PBM, 1000);
+            fs::create_symlink("/dev/full", dir / "full" / "frame_000000.pbm");
+            HackEmulator other;
+            other.loadProgram(commands);
+            REQUIRE_THROWS_AS(full.captureFrame(other), std::runtime_error);
+            REQUIRE(full.getFrameCount() == 0);
+        }
+    }
+
+    written.close();
+    fs::remove_all(dir);
+}
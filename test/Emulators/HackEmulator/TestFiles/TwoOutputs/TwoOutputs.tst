@@ -0,0 +1,20 @@
+// Copies RAM[100] + 1 to RAM[101] in a loop. RAM[101] is checked before
+// RAM[100] changes and again after.
+
+load TwoOutputs.asm,
+compare-to TwoOutputs.cmp,
+
+set RAM[100] 7,
+repeat 12 {
+  ticktock;
+}
+output-list RAM[101]%D1.6.1;
+output;
+
+set RAM[100] 41,
+repeat 12 {
+  ticktock;
+}
+ticktock;
+output-list RAM[100]%D1.6.1 RAM[101]%D1.6.1;
+output;
@@ -5,6 +5,14 @@
 
 #include "Emulators/FileLoader.hpp"
 #include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/ExecutionProfiler.hpp"
+#include "Emulators/HackEmulator/InstructionMix.hpp"
+#include "Emulators/HackEmulator/ScreenRecorder.hpp"
+#include "Emulators/HackEmulator/BatchRunner.hpp"
+#include "Emulators/HackEmulator/ExecutionTracer.hpp"
+#include "Emulators/HackEmulator/NativeTranslator.hpp"
+#include "Emulators/HackEmulator/WideHackEmulator.hpp"
+#include "Emulators/HackEmulator/KeyboardInput.hpp"
 
 TEST_CASE("Hack Emulator runs Project7/MemoryAccess/BasicTest Test Case", "[HackEmulator][BasicTest]") {
     FileLoader loader;
@@ -19,9 +27,7 @@ TEST_CASE("Hack Emulator runs Project7/MemoryAccess/BasicTest Test Case", "[Hack
     emu.setRamValue(3, 3000);
     emu.setRamValue(4, 3010);
 
-    for (int i = 0; i < 600; i++) {
-        emu.executeNextInstruction();
-    }
+    emu.run(600);
 
     REQUIRE(emu.peek(256) == 472);
     REQUIRE(emu.peek(300) == 10);
@@ -42,9 +48,7 @@ TEST_CASE("Hack Emulator runs Project7/MemoryAccess/PointerTest Test Case", "[Ha
 
     emu.setRamValue(0, 256);
 
-    for (int i = 0; i < 450; i++) {
-        emu.executeNextInstruction();
-    }
+    emu.run(450);
 
     REQUIRE(emu.peek(256) == 6084);
     REQUIRE(emu.peek(3) == 3030);
@@ -62,9 +66,7 @@ TEST_CASE("Hack Emulator runs Project7/MemoryAccess/StaticTest Test Case", "[Hac
 
     emu.setRamValue(0, 256);
 
-    for (int i = 0; i < 200; i++) {
-        emu.executeNextInstruction();
-    }
+    emu.run(200);
 
     REQUIRE(emu.peek(256) == 1110);
 }
@@ -78,9 +80,7 @@ TEST_CASE("Hack Emulator runs Project7/StackArithmetic/SimpleAdd Test Case", "[H
 
     emu.setRamValue(0, 256);
 
-    for (int i = 0; i < 600; i++) {
-        emu.executeNextInstruction();
-    }
+    emu.run(600);
 
     REQUIRE(emu.peek(0) == 257);
     REQUIRE(emu.peek(256) == 15);
@@ -95,9 +95,7 @@ TEST_CASE("Hack Emulator runs Project7/StackArithmetic/StackTest Test Case", "[H
 
     emu.setRamValue(0, 256);
 
-    for (int i = 0; i < 600; i++) {
-        emu.executeNextInstruction();
-    }
+    emu.run(600);
 
     REQUIRE(emu.peek(0) == 266);
     REQUIRE(emu.peek(256) == -1);
@@ -120,9 +118,7 @@ TEST_CASE("Hack Emulator runs Project8/Function Calls/FibonacciElement Test Case
     std::vector<int16_t> commands = loader.loadFile("../test/Emulators/HackEmulator/integration/TestCases/Project8/Function Calls/FibonacciElement/FibonacciElement.hack");
     emu.loadProgram(commands);
 
-    for (int i = 0; i < 6000; i++) {
-        emu.executeNextInstruction();
-    }
+    REQUIRE(emu.run(1000000).reason == StopReason::HALTED);
 
     REQUIRE(emu.peek(0) == 262);
     REQUIRE(emu.peek(261) == 3);
@@ -155,9 +151,7 @@ TEST_CASE("Hack Emulator runs Project8/Function Calls/NestedCall Test Case", "[H
         emu.setRamValue(i, -1);
     }
 
-    for (int i = 0; i < 4000; i++) {
-        emu.executeNextInstruction();
-    }
+    REQUIRE(emu.run(1000000).reason == StopReason::HALTED);
 
     REQUIRE(emu.peek(0) == 261);
     REQUIRE(emu.peek(1) == 261);
@@ -188,9 +182,7 @@ TEST_CASE("Hack Emulator runs Project8/Function Calls/SimpleFunction Test Case",
     emu.setRamValue(315, 3010);
     emu.setRamValue(316, 4010);
 
-    for (int i = 0; i < 300; i++) {
-        emu.executeNextInstruction();
-    }
+    emu.run(300);
 
     REQUIRE(emu.peek(0) == 311);
     REQUIRE(emu.peek(1) == 305);
@@ -208,9 +200,7 @@ TEST_CASE("Hack Emulator runs Project8/Function Calls/StaticsTest Test Case", "[
     emu.loadProgram(commands);
     emu.setRamValue(0, 256);
 
-    for (int i = 0; i < 2500; i++) {
-        emu.executeNextInstruction();
-    }
+    REQUIRE(emu.run(1000000).reason == StopReason::HALTED);
 
     REQUIRE(emu.peek(0) == 263);
     REQUIRE(emu.peek(261) == -2);
@@ -229,9 +219,7 @@ TEST_CASE("Hack Emulator runs Project8/Program Flow/BasicLoop Test Case", "[Hack
     emu.setRamValue(2, 400);
     emu.setRamValue(400, 3);
 
-    for (int i = 0; i < 600; i++) {
-        emu.executeNextInstruction();
-    }
+    emu.run(600);
 
     REQUIRE(emu.peek(0) == 257);
     REQUIRE(emu.peek(256) == 6);
@@ -250,9 +238,7 @@ TEST_CASE("Hack Emulator runs Project8/Program Flow/FibonacciSeries Test Case",
     emu.setRamValue(400, 6);
     emu.setRamValue(401, 3000);
 
-    for (int i = 0; i < 1100; i++) {
-        emu.executeNextInstruction();
-    }
+    emu.run(1100);
 
     REQUIRE(emu.peek(3000) == 0);
     REQUIRE(emu.peek(3001) == 1);
@@ -262,3 +248,464 @@ TEST_CASE("Hack Emulator runs Project8/Program Flow/FibonacciSeries Test Case",
     REQUIRE(emu.peek(3005) == 5);
 }
 
+
+TEST_CASE("Hack Emulator block cache and fast memory match the interpreter", "[HackEmulator][BlockCache]") {
+    const std::string base = "../test/Emulators/HackEmulator/integration/TestCases/";
+    const std::vector<std::string> programs = {
+        "Project7/StackArithmetic/StackTest/StackTest.hack",
+        "Project7/MemoryAccess/BasicTest/BasicTest.hack",
+        "Project8/Function Calls/FibonacciElement/FibonacciElement.hack",
+        "Project8/Function Calls/StaticsTest/StaticsTest.hack",
+        "Project8/Program Flow/FibonacciSeries/FibonacciSeries.hack"
+    };
+
+    FileLoader loader;
+    for (const std::string& program : programs) {
+        for (MemoryMode memory : { MemoryMode::STRICT, MemoryMode::FAST }) {
+            std::vector<int16_t> commands = loader.loadFile(base + program);
+
+            HackEmulator interpreted;
+            HackEmulator cached;
+            cached.setExecutionMode(ExecutionMode::BLOCK_CACHE);
+            cached.setMemoryMode(memory);
+            for (HackEmulator* emu : { &interpreted, &cached }) {
+                emu->loadProgram(commands);
+                emu->setRamValue(0, 256);
+                emu->setRamValue(1, 300);
+                emu->setRamValue(2, 400);
+                emu->setRamValue(3, 3000);
+                emu->setRamValue(4, 3010);
+                emu->setRamValue(400, 6);
+                emu->setRamValue(401, 3000);
+            }
+
+            // Odd budgets make the cached run split blocks at the limit
+            for (uint64_t budget : { 1, 7, 333, 5000 }) {
+                RunResult expected = interpreted.run(budget);
+                RunResult actual = cached.run(budget);
+                REQUIRE(actual.cycles == expected.cycles);
+                REQUIRE(actual.pc == expected.pc);
+            }
+
+            REQUIRE(cached.getARegister() == interpreted.getARegister());
+            REQUIRE(cached.getDRegister() == interpreted.getDRegister());
+            for (uint16_t addr = 0; addr < 24577; addr++) {
+                if (cached.peek(addr) != interpreted.peek(addr)) {
+                    FAIL(program << ": RAM[" << addr << "] differs");
+                }
+            }
+
+            // Breakpoints in the middle of a cached block still stop exactly there
+            for (HackEmulator* emu : { &interpreted, &cached }) {
+                emu->loadProgram(commands);
+                emu->setRamValue(0, 256);
+            }
+            RunResult expected = interpreted.runUntil(17, 1000);
+            RunResult actual = cached.runUntil(17, 1000);
+            REQUIRE(actual.reason == expected.reason);
+            REQUIRE(actual.cycles == expected.cycles);
+        }
+    }
+
+    // A push with SP == 0 writes over SP itself before incrementing it
+    const std::vector<int16_t> pushOntoSp = {
+        5,
+        static_cast<int16_t>(0b1110110000010000),   // D=A
+        0,
+        static_cast<int16_t>(0b1111110000100000),   // A=M
+        static_cast<int16_t>(0b1110001100001000),   // M=D
+        0,
+        static_cast<int16_t>(0b1111110111001000),   // M=M+1
+        7,
+        static_cast<int16_t>(0b1110101010000111)    // 0;JMP
+    };
+    HackEmulator interpreted;
+    HackEmulator cached;
+    HackEmulator fast;
+    cached.setExecutionMode(ExecutionMode::BLOCK_CACHE);
+    fast.setExecutionMode(ExecutionMode::BLOCK_CACHE);
+    fast.setMemoryMode(MemoryMode::FAST);
+    for (HackEmulator* emu : { &interpreted, &cached, &fast }) {
+        emu->loadProgram(pushOntoSp);
+        emu->setRamValue(0, 0);
+        emu->run(20);
+    }
+    REQUIRE(interpreted.peek(0) == 6);
+    REQUIRE(cached.peek(0) == 6);
+    REQUIRE(fast.peek(0) == 6);
+    REQUIRE(cached.getARegister() == interpreted.getARegister());
+    REQUIRE(fast.getARegister() == interpreted.getARegister());
+}
+
+TEST_CASE("Hack Emulator profiler report joins counts with the assembler listing", "[HackEmulator][Profiler]") {
+    const std::string dir = "../test/Emulators/HackEmulator/integration/TestCases/Project6/Max/";
+    FileLoader loader;
+    HackEmulator emu;
+    emu.loadProgram(loader.loadFile(dir + "Max.hack"));
+    emu.setRamValue(0, 3);
+    emu.setRamValue(1, 9);
+
+    ExecutionProfiler profiler;
+    REQUIRE(emu.run(100000, profiler).reason == StopReason::HALTED);
+    REQUIRE(emu.peek(2) == 9);
+    REQUIRE(profiler.getExecutions(6) == 1);   // Its R1 branch
+    REQUIRE(profiler.getExecutions(10) == 0);  // ITSR0 branch
+    REQUIRE(profiler.getReads(1) == 2);
+    REQUIRE(profiler.getWrites(2) == 1);
+
+    std::ostringstream report;
+    profiler.writeReport(report, dir + "Max.listing.txt", 5);
+    std::string text = report.str();
+    REQUIRE(text.find("Instructions executed: " + std::to_string(profiler.getTotalExecutions())) != std::string::npos);
+    REQUIRE(text.find("| END                      | @END") != std::string::npos);
+    REQUIRE(text.find("| D = R0 - R1") != std::string::npos);
+    REQUIRE(text.find("| OUTPUT_D") != std::string::npos);
+
+    REQUIRE_THROWS_AS(profiler.writeReport(report, dir + "Missing.listing.txt"), std::runtime_error);
+}
+
+TEST_CASE("Hack Emulator instruction mix classifies A-instructions from the listing", "[HackEmulator][InstructionMix]") {
+    const std::string dir = "../test/Emulators/HackEmulator/integration/TestCases/Project6/Max/";
+    FileLoader loader;
+    HackEmulator emu;
+    emu.loadProgram(loader.loadFile(dir + "Max.hack"));
+    emu.setRamValue(0, 3);
+    emu.setRamValue(1, 9);
+
+    InstructionMix mix;
+    REQUIRE(emu.runUntil(14, 1000, mix).reason == StopReason::BREAKPOINT);
+    InstructionMixSummary summary = mix.summarize(emu, dir + "Max.listing.txt");
+    REQUIRE(summary.instructions == emu.getCycleCount());
+    REQUIRE(summary.a_instructions == 6);
+    REQUIRE(summary.a_symbols == 6);
+    REQUIRE(summary.a_constants == 0);
+    REQUIRE(summary.branches_not_taken == 1);  // D;JGT to ITSR0
+    REQUIRE(summary.jump_taken.at("JMP") == 1);
+    REQUIRE(summary.comp.at("D-M") == 1);
+
+    REQUIRE_THROWS_AS(mix.summarize(emu, dir + "Missing.listing.txt"), std::runtime_error);
+}
+
+TEST_CASE("Hack Emulator reruns scenarios from a restored snapshot", "[HackEmulator][Snapshot]") {
+    FileLoader loader;
+    HackEmulator emu;
+    emu.loadProgram(loader.loadFile("../test/Emulators/HackEmulator/integration/TestCases/Project8/Function Calls/StaticsTest/StaticsTest.hack"));
+    emu.setRamValue(0, 256);
+
+    // Stop after the bootstrap has called Sys.init
+    emu.run(60);
+    HackSnapshot booted = emu.snapshot();
+
+    for (int scenario = 0; scenario < 3; scenario++) {
+        emu.restore(booted);
+        RunResult result = emu.run(1000000);
+        REQUIRE(result.reason == StopReason::HALTED);
+        REQUIRE(emu.getCycleCount() == 60 + result.cycles);
+        REQUIRE(emu.peek(0) == 263);
+        REQUIRE(emu.peek(261) == -2);
+        REQUIRE(emu.peek(262) == 8);
+    }
+}
+
+TEST_CASE("Hack Emulator records Pong frames from dirty rows", "[HackEmulator][Screen]") {
+    FileLoader loader;
+    HackEmulator emu;
+    emu.loadProgram(loader.loadFile("../test/HackAssembler/integration/expectedOutput/pong/Pong.hack"));
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "HackEmulator_pong_frames";
+    ScreenRecorder recorder(dir.string(), FrameFormat::PBM, 500000);
+    recorder.run(emu, 5000000);
+    REQUIRE(recorder.getFrameCount() == 10);
+
+    // The last frame only re-encoded the rows the ball and bat touched
+    REQUIRE(recorder.getLastDirtyRowCount() > 0);
+    REQUIRE(recorder.getLastDirtyRowCount() < HackEmulator::SCREEN_ROWS);
+
+    // The encoded frame matches a full scan of the screen
+    const std::vector<uint8_t>& frame = recorder.getFrame();
+    const size_t header = std::string("P4\n512 256\n").size();
+    for (uint16_t row = 0; row < HackEmulator::SCREEN_ROWS; row++) {
+        for (uint16_t col = 0; col < 512; col++) {
+            bool black = (emu.peek(HackEmulator::SCREEN_BASE + row * 32 + col / 16) >> (col % 16)) & 1;
+            bool encoded = (frame[header + row * 64 + col / 8] >> (7 - col % 8)) & 1;
+            if (black != encoded) {
+                FAIL("Pixel (" << col << ", " << row << ") differs");
+            }
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Hack Emulator replays Pong keyboard input", "[HackEmulator][Keyboard]") {
+    FileLoader loader;
+    std::vector<int16_t> program = loader.loadFile("../test/HackAssembler/integration/expectedOutput/pong/Pong.hack");
+    const uint64_t cycles = 8500000;
+
+    // Holds the right arrow, taps the left arrow, releases
+    KeyboardInput script;
+    script.schedule(1000000, 132);
+    script.schedule(7000000, 130);
+    script.schedule(7000100, 0);
+    script.schedule(8000000, 0);
+
+    auto screenAfter = [&](KeyboardInput* input, ExecutionMode mode) {
+        HackEmulator emu;
+        emu.setExecutionMode(mode);
+        emu.loadProgram(program);
+        emu.setKeyboardInput(input);
+        emu.run(cycles);
+        std::vector<int16_t> screen;
+        for (uint16_t addr = HackEmulator::SCREEN_BASE; addr < HackEmulator::KBD_ADDRESS; addr++) {
+            screen.push_back(emu.peek(addr));
+        }
+        return screen;
+    };
+
+    std::vector<int16_t> played = screenAfter(&script, ExecutionMode::INTERPRETED);
+    REQUIRE(script.getRecording().size() == 4);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "HackEmulator_pong.keys";
+    script.save(path.string());
+
+    // The bat moved, and the saved recording reproduces the session
+    REQUIRE(played != screenAfter(nullptr, ExecutionMode::INTERPRETED));
+    KeyboardInput replay = KeyboardInput::load(path.string());
+    std::filesystem::remove(path);
+    REQUIRE(screenAfter(&replay, ExecutionMode::BLOCK_CACHE) == played);
+    REQUIRE(replay.getRecording() == script.getRecording());
+}
+
+TEST_CASE("Hack Emulator skips Sys.wait loops exactly", "[HackEmulator][LoopAcceleration]") {
+    FileLoader loader;
+    std::vector<int16_t> program = loader.loadFile("../test/HackAssembler/integration/expectedOutput/pong/Pong.hack");
+    const uint16_t SYS_WAIT = 27194;     // Entry of the compiled Sys.wait in Pong.hack
+
+    // Calls Sys.wait(duration) with the frame a VM call would build, returning to address 0
+    auto callWait = [&](HackEmulator& emu, int16_t duration) {
+        emu.loadProgram(program);
+        emu.setRamValue(256, duration);
+        for (uint16_t addr = 257; addr < 262; addr++) {
+            emu.setRamValue(addr, 0);
+        }
+        emu.setRamValue(HackEmulator::STACK_POINTER, 262);
+        emu.setRamValue(HackEmulator::LCL_POINTER, 262);
+        emu.setRamValue(HackEmulator::ARG_POINTER, 256);
+        emu.setPC(SYS_WAIT);
+    };
+
+    for (ExecutionMode mode : { ExecutionMode::INTERPRETED, ExecutionMode::BLOCK_CACHE }) {
+        for (int16_t duration : { 1, 50, 700 }) {
+            HackEmulator plain;
+            HackEmulator fast;
+            fast.setExecutionMode(mode);
+            fast.setLoopAcceleration(true);
+            callWait(plain, duration);
+            callWait(fast, duration);
+
+            RunResult expected = plain.runUntil(0, 10000000);
+            RunResult result = fast.runUntil(0, 10000000);
+            REQUIRE(expected.reason == StopReason::BREAKPOINT);
+            REQUIRE(result.reason == StopReason::BREAKPOINT);
+            REQUIRE(result.cycles == expected.cycles);
+            REQUIRE(fast.getAcceleratedCycles() > expected.cycles / 2);
+
+            REQUIRE(fast.getARegister() == plain.getARegister());
+            REQUIRE(fast.getDRegister() == plain.getDRegister());
+            for (uint16_t addr = 0; addr < HackEmulator::SCREEN_BASE; addr++) {
+                if (fast.peek(addr) != plain.peek(addr)) {
+                    FAIL("RAM[" << addr << "] differs after Sys.wait(" << duration << ")");
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Hack Emulator trace file matches a stepped run", "[HackEmulator][Trace]") {
+    FileLoader loader;
+    std::vector<int16_t> program = loader.loadFile(
+        "../test/Emulators/HackEmulator/integration/TestCases/Project8/Function Calls/FibonacciElement/FibonacciElement.hack");
+
+    HackEmulator emu;
+    emu.loadProgram(program);
+    emu.setRamValue(HackEmulator::STACK_POINTER, 256);
+
+    // A small buffer makes the emulator wait on the writer thread
+    ExecutionTracer tracer(64, TraceOverflow::WAIT);
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "HackEmulator_fibonacci.trace";
+    TraceWriter writer(tracer, path.string());
+    RunResult result = emu.run(6000, tracer);
+    writer.finish();
+    REQUIRE(writer.getRecordCount() == result.cycles);
+
+    std::vector<TraceRecord> records = TraceWriter::readTrace(path.string());
+    std::filesystem::remove(path);
+    REQUIRE(records.size() == result.cycles);
+
+    HackEmulator reference;
+    reference.loadProgram(program);
+    reference.setRamValue(HackEmulator::STACK_POINTER, 256);
+    for (const TraceRecord& record : records) {
+        uint16_t pc = reference.getPC();
+        int16_t a = reference.getARegister();
+        reference.executeNextInstruction();
+        if (record.pc != pc || record.a_register != reference.getARegister() ||
+            record.d_register != reference.getDRegister()) {
+            FAIL("Trace differs at cycle " << reference.getCycleCount());
+        }
+        if (record.flags & ExecutionTracer::WROTE_M) {
+            REQUIRE(record.m_address == static_cast<uint16_t>(a));
+            REQUIRE(record.m_value == reference.peek(record.m_address));
+        }
+    }
+    REQUIRE(reference.getPC() == emu.getPC());
+}
+
+// Translated at build time by HackEmulator_aot (see HACK_NATIVE_PROGRAMS)
+uint64_t hack_native_StackTest(int16_t*, int16_t&, int16_t&, uint16_t&, uint64_t);
+uint64_t hack_native_BasicTest(int16_t*, int16_t&, int16_t&, uint16_t&, uint64_t);
+uint64_t hack_native_FibonacciElement(int16_t*, int16_t&, int16_t&, uint16_t&, uint64_t);
+uint64_t hack_native_StaticsTest(int16_t*, int16_t&, int16_t&, uint16_t&, uint64_t);
+uint64_t hack_native_FibonacciSeries(int16_t*, int16_t&, int16_t&, uint16_t&, uint64_t);
+uint64_t hack_native_Pong(int16_t*, int16_t&, int16_t&, uint16_t&, uint64_t);
+
+TEST_CASE("Hack Emulator native translations match the interpreter", "[HackEmulator][Native]") {
+    const std::string base = "../test/Emulators/HackEmulator/integration/TestCases/";
+    const std::vector<std::pair<std::string, NativeProgram>> programs = {
+        { base + "Project7/StackArithmetic/StackTest/StackTest.hack", hack_native_StackTest },
+        { base + "Project7/MemoryAccess/BasicTest/BasicTest.hack", hack_native_BasicTest },
+        { base + "Project8/Function Calls/FibonacciElement/FibonacciElement.hack", hack_native_FibonacciElement },
+        { base + "Project8/Function Calls/StaticsTest/StaticsTest.hack", hack_native_StaticsTest },
+        { base + "Project8/Program Flow/FibonacciSeries/FibonacciSeries.hack", hack_native_FibonacciSeries },
+        { "../test/HackAssembler/integration/expectedOutput/pong/Pong.hack", hack_native_Pong }
+    };
+
+    FileLoader loader;
+    for (const auto& [path, native] : programs) {
+        // Odd budgets stop mid-block and inside the final halt loop
+        for (uint64_t budget : { 0, 1, 7, 1000, 12345, 100001, 2000000 }) {
+            HackEmulator emu;
+            emu.setMemoryMode(MemoryMode::FAST);
+            emu.setHaltDetection(false);
+            emu.loadProgram(loader.loadFile(path));
+            emu.setRamValue(HackEmulator::STACK_POINTER, 256);
+            emu.setRamValue(HackEmulator::ARG_POINTER, 400);
+            RunResult expected = emu.run(budget);
+
+            std::vector<int16_t> ram(32768, 0);
+            ram[HackEmulator::STACK_POINTER] = 256;
+            ram[HackEmulator::ARG_POINTER] = 400;
+            int16_t a = 0;
+            int16_t d = 0;
+            uint16_t pc = 0;
+            uint64_t cycles = native(ram.data(), a, d, pc, budget);
+
+            INFO(path << " for " << budget << " cycles");
+            REQUIRE(cycles == expected.cycles);
+            REQUIRE(pc == expected.pc);
+            REQUIRE(a == emu.getARegister());
+            REQUIRE(d == emu.getDRegister());
+            for (uint16_t addr = 0; addr <= 24576; addr++) {
+                if (ram[addr] != emu.peek(addr)) {
+                    FAIL("RAM[" << addr << "] is " << ram[addr] << ", expected " << emu.peek(addr));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Hack Emulator wide lanes match separate runs", "[HackEmulator][Wide]") {
+    FileLoader loader;
+    std::vector<int16_t> program = loader.loadFile(
+        "../test/Emulators/HackEmulator/integration/TestCases/Project8/Program Flow/FibonacciSeries/FibonacciSeries.hack");
+
+    // Each lane generates a series of a different length
+    auto setup = [](auto setRam, size_t lane) {
+        setRam(HackEmulator::STACK_POINTER, 256);
+        setRam(HackEmulator::LCL_POINTER, 300);
+        setRam(HackEmulator::ARG_POINTER, 400);
+        setRam(400, static_cast<int16_t>(lane + 1));
+        setRam(401, 3000);
+    };
+
+    for (uint64_t budget : { 1, 57, 400, 5000 }) {
+        WideHackEmulator<16> wide;
+        wide.loadProgram(program);
+        for (size_t lane = 0; lane < 16; lane++) {
+            setup([&](uint16_t addr, int16_t value) { wide.setRamValue(lane, addr, value); }, lane);
+        }
+        std::array<RunResult, 16> results = wide.run(budget);
+
+        for (size_t lane = 0; lane < 16; lane++) {
+            HackEmulator emu;
+            emu.setMemoryMode(MemoryMode::FAST);
+            emu.setHaltDetection(false);
+            emu.loadProgram(program);
+            setup([&](uint16_t addr, int16_t value) { emu.setRamValue(addr, value); }, lane);
+            RunResult expected = emu.run(budget);
+
+            INFO("Lane " << lane << " for " << budget << " cycles");
+            REQUIRE(results[lane].cycles == expected.cycles);
+            REQUIRE(results[lane].pc == expected.pc);
+            REQUIRE(wide.getARegister(lane) == emu.getARegister());
+            REQUIRE(wide.getDRegister(lane) == emu.getDRegister());
+            for (uint16_t addr = 0; addr <= 24576; addr++) {
+                if (wide.peek(lane, addr) != emu.peek(addr)) {
+                    FAIL("RAM[" << addr << "] is " << wide.peek(lane, addr) << ", expected " << emu.peek(addr));
+                }
+            }
+        }
+        if (budget == 5000) {
+            REQUIRE(wide.peek(15, 3015) == 610);
+        }
+    }
+}
+
+TEST_CASE("Hack Emulator batch runner runs the CPU test scripts", "[HackEmulator][Batch]") {
+    const std::string base = "../test/Emulators/HackEmulator/integration/TestCases/";
+
+    BatchJob nested = BatchRunner::loadTestScript(base + "Project8/Function Calls/NestedCall/NestedCall.tst");
+    REQUIRE(nested.name == "NestedCall");
+    REQUIRE(nested.programPath.find("Sys.hack") != std::string::npos);
+    REQUIRE(nested.steps.size() == 1);
+    REQUIRE(nested.steps[0].cycles == 4000);
+    REQUIRE(nested.steps[0].setRam.size() == 51);
+    REQUIRE(nested.steps[0].setRam[3].first == 3);
+    REQUIRE(nested.steps[0].setRam[3].second == -3);
+    REQUIRE(nested.steps[0].checks.size() == 7);
+    REQUIRE(nested.steps[0].checks[6].address == 6);
+    REQUIRE(nested.steps[0].checks[6].expected == 246);
+
+    // Both outputs of StackTest are checked
+    BatchJob stack = BatchRunner::loadTestScript(base + "Project7/StackArithmetic/StackTest/StackTest.tst");
+    REQUIRE(stack.steps.size() == 2);
+    REQUIRE(stack.steps[1].cycles == 0);
+    REQUIRE(stack.steps[1].checks.size() == 5);
+    REQUIRE(stack.steps[1].checks[4].address == 265);
+    REQUIRE(stack.steps[1].checks[4].expected == -91);
+
+    std::vector<BatchJob> corpus = BatchRunner::discoverTestScripts(base);
+    REQUIRE(corpus.size() == 11);
+
+    // Several copies so workers run out of their own jobs and steal
+    std::vector<BatchJob> jobs;
+    for (int copy = 0; copy < 4; copy++) {
+        jobs.insert(jobs.end(), corpus.begin(), corpus.end());
+    }
+    for (ExecutionMode mode : { ExecutionMode::INTERPRETED, ExecutionMode::BLOCK_CACHE }) {
+        std::vector<BatchResult> results = BatchRunner(3, mode).run(jobs);
+        REQUIRE(results.size() == jobs.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            INFO(results[i].name << (results[i].failures.empty() ? "" : ": " + results[i].failures.front()));
+            REQUIRE(results[i].name == jobs[i].name);
+            REQUIRE(results[i].passed);
+        }
+    }
+
+    // Failures are reported per job
+    BatchJob broken = nested;
+    broken.steps[0].checks[6].expected = 0;
+    broken.programPath = base + "Missing.hack";
+    std::vector<BatchResult> results = BatchRunner(2).run({ nested, broken });
+    REQUIRE(results[0].passed);
+    REQUIRE_FALSE(results[1].passed);
+    REQUIRE(results[1].failures.size() == 1);
+}
@@ -63,4 +63,233 @@ TEST_CASE("VM Decoder: Push and Pop", "[decoder]") {
         REQUIRE(d.segment == Segment::POINTER);
         REQUIRE(d.value == 1);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("VM Parser: Packed and linked bytecode", "[decoder][bytecode]") {
+    VMEmulator vm;
+    vm.loadRawProgram({
+        "label LOOP",
+        "push local 3",          // 0
+        "lt",                    // 1
+        "not",                   // 2
+        "if-goto LOOP",          // 3
+        "call Math.multiply 2",  // 4
+        "goto LOOP",             // 5
+        "function Math.multiply 3",
+        "return"                 // 6
+    });
+    const std::vector<VMInstruction>& bytecode = vm.getBytecode();
+    REQUIRE(bytecode.size() == 7);
+    REQUIRE(sizeof(VMInstruction) == 8);
+
+    REQUIRE(bytecode[0].opcode == Opcode::PUSH_LOCAL);
+    REQUIRE(bytecode[0].segment == Segment::LOCAL);
+    REQUIRE(bytecode[0].value == 3);
+
+    REQUIRE(bytecode[1].opcode == Opcode::LT);
+    REQUIRE(bytecode[2].opcode == Opcode::NOT);
+
+    // Targets are instruction indices after linking
+    REQUIRE(bytecode[3].opcode == Opcode::IF_GOTO);
+    REQUIRE(bytecode[3].target == 0);
+    REQUIRE(bytecode[5].target == 0);
+    REQUIRE(bytecode[4].opcode == Opcode::CALL);
+    REQUIRE(bytecode[4].value == 2);
+    REQUIRE(bytecode[4].target == 6);
+    REQUIRE(bytecode[4].locals == 3);
+    REQUIRE(bytecode[6].opcode == Opcode::RETURN);
+
+    SECTION("Malformed commands are rejected at load time") {
+        REQUIRE_THROWS_AS(vm.loadRawProgram({"push constant 1", "mul"}), std::runtime_error);
+        REQUIRE_THROWS_AS(vm.loadRawProgram({"push heap 1"}), std::runtime_error);
+        REQUIRE_THROWS_AS(vm.loadRawProgram({"pop local"}), std::runtime_error);
+        REQUIRE_THROWS_AS(vm.loadRawProgram({"pop constant 0"}), std::runtime_error);
+        REQUIRE_THROWS_AS(vm.loadRawProgram({"call Main.main"}), std::runtime_error);
+    }
+
+    SECTION("Undefined symbols are rejected at load time") {
+        REQUIRE_THROWS_AS(vm.loadRawProgram({"goto END"}), std::runtime_error);
+        REQUIRE_THROWS_AS(vm.loadRawProgram({"call Main.main 0"}), std::runtime_error);
+    }
+
+    SECTION("Decoding names the command") {
+        REQUIRE(vm.decode("if-goto LOOP").command == "LOOP");
+        REQUIRE(vm.decode("call Math.multiply 2").command == "Math.multiply");
+    }
+}
+
+TEST_CASE("VM Program Flow: Linked branches and calls", "[bytecode]") {
+    VMEmulator vm;
+
+    SECTION("Countdown loop") {
+        vm.loadRawProgram({
+            "push constant 5", "pop temp 0",
+            "label LOOP",
+            "push temp 0", "push constant 1", "sub", "pop temp 0",
+            "push temp 0", "if-goto LOOP"
+        });
+        for (int i = 0; i < 2 + 5 * 6; i++) {
+            vm.executeNextInstruction();
+        }
+        REQUIRE(vm.peekTemp(0) == 0);
+        REQUIRE(vm.peek(0) == 256);
+    }
+
+    SECTION("Call and return") {
+        vm.loadRawProgram({
+            "push constant 6", "push constant 7", "call Math.sum 2",
+            "label END", "goto END",
+            "function Math.sum 1",
+            "push argument 0", "push argument 1", "add", "pop local 0",
+            "push local 0", "return"
+        });
+        for (int i = 0; i < 12; i++) {
+            vm.executeNextInstruction();
+        }
+        REQUIRE(vm.peek(0) == 257);
+        REQUIRE(vm.peekStack() == 13);
+    }
+}
+
+TEST_CASE("VM Dispatch: Switch and threaded cores agree", "[bytecode][dispatch]") {
+    // Touches every opcode, then falls off the end of the program
+    const std::vector<std::string> program = {
+        "push constant 3000", "pop pointer 0", "push constant 3010", "pop pointer 1",
+        "push constant 4", "pop temp 0",
+        "label LOOP",
+        "push temp 0", "push constant 1", "sub", "pop temp 0",
+        "push temp 0", "call Main.mix 1", "pop static 2",
+        "push temp 0", "push constant 0", "gt", "if-goto LOOP",
+        "push constant 1", "neg", "not", "push constant 0", "eq", "goto END",
+        "function Main.mix 2",
+        "push argument 0", "pop local 1", "push local 1", "push argument 0", "add", "pop this 1",
+        "push this 1", "push constant 6", "and", "pop that 2", "push that 2", "push constant 1", "or",
+        "push static 2", "lt", "push pointer 1", "pop local 0", "push local 0", "push local 1", "lt", "add",
+        "return",
+        "label END"
+    };
+
+    VMEmulator threaded;
+    VMEmulator switched;
+    threaded.setDispatch(VMDispatch::THREADED);
+    switched.setDispatch(VMDispatch::SWITCH);
+    threaded.loadRawProgram(program);
+    switched.loadRawProgram(program);
+    for (VMEmulator* vm : { &threaded, &switched }) {
+        vm->poke(1, 300);
+        vm->poke(2, 400);
+    }
+
+    uint64_t steps = threaded.executeInstructions(1000);
+    REQUIRE(steps < 1000);
+    REQUIRE(switched.executeInstructions(1000) == steps);
+    REQUIRE(threaded.executeInstructions(10) == 0);
+
+    // Stepping one at a time ends in the same place
+    VMEmulator stepped;
+    stepped.loadRawProgram(program);
+    stepped.poke(1, 300);
+    stepped.poke(2, 400);
+    for (uint64_t i = 0; i < steps; i++) {
+        stepped.executeNextInstruction();
+    }
+
+    for (uint16_t addr = 0; addr < 3100; addr++) {
+        REQUIRE(switched.peek(addr) == threaded.peek(addr));
+        REQUIRE(stepped.peek(addr) == threaded.peek(addr));
+    }
+    REQUIRE(threaded.peek(0) == 257);
+    REQUIRE(threaded.peekStack() == -1);
+    REQUIRE(threaded.peekTemp(0) == 0);
+}
+
+TEST_CASE("VM Superinstructions: Fused code runs like plain code", "[bytecode][superinstructions]") {
+    // The sequences CodeGenerator emits for loops, arrays and do statements
+    const std::vector<std::string> program = {
+        "push constant 9", "goto MID",
+        "label AGAIN",
+        "push constant 0", "label MID", "not", "pop temp 1",
+        "push temp 2", "push constant 1", "add", "pop temp 2",
+        "push temp 2", "push constant 2", "lt", "if-goto AGAIN",
+        "push constant 0", "pop local 0",
+        "label LOOP",
+        "push local 0", "push constant 5", "lt", "not", "if-goto END",
+        "push constant 3000", "push local 0", "add",
+        "push constant 3000", "push local 0", "add", "pop pointer 1", "push that 0",
+        "push local 0", "add",
+        "pop temp 0", "pop pointer 1", "push temp 0", "pop that 0",
+        "push local 0", "call Main.touch 1", "pop temp 0",
+        "push constant 0", "not", "not", "if-goto END",
+        "push local 0", "push constant 1", "add", "pop local 0",
+        "goto LOOP",
+        "function Main.touch 0",
+        "push argument 0", "push constant 1", "add", "pop static 0",
+        "push constant 0", "return",
+        "label END"
+    };
+
+    SECTION("Only the first slot of each sequence changes") {
+        VMEmulator vm;
+        vm.loadRawProgram(program);
+        const std::vector<VMInstruction>& code = vm.getBytecode();
+        std::vector<VMInstruction> fused = VMParser::fuse(code);
+        REQUIRE(fused.size() == code.size());
+
+        std::vector<Opcode> heads;
+        for (size_t i = 0; i < code.size(); i++) {
+            if (fused[i].opcode != code[i].opcode) {
+                heads.push_back(fused[i].opcode);
+            }
+        }
+        REQUIRE(heads == std::vector<Opcode>{
+            Opcode::PUSH_NOT, Opcode::NOT_IF_GOTO, Opcode::ARRAY_READ, Opcode::ARRAY_WRITE,
+            Opcode::DISCARD, Opcode::PUSH_NOT, Opcode::NOT_IF_GOTO
+        });
+        REQUIRE(std::string(VMParser::mnemonic(Opcode::ARRAY_WRITE)) == "array-write");
+    }
+
+    SECTION("RAM and step counts match for every budget") {
+        for (VMDispatch dispatch : { VMDispatch::SWITCH, VMDispatch::THREADED }) {
+            for (uint64_t budget = 1; budget <= 5; budget++) {
+                VMEmulator plain;
+                VMEmulator fused;
+                for (VMEmulator* vm : { &plain, &fused }) {
+                    vm->setDispatch(dispatch);
+                    vm->loadRawProgram(program);
+                    vm->poke(0, 256);
+                    vm->poke(1, 300);
+                    vm->poke(2, 400);
+                }
+                fused.setSuperinstructions(true);
+
+                uint64_t steps;
+                do {
+                    steps = plain.executeInstructions(budget);
+                    REQUIRE(fused.executeInstructions(budget) == steps);
+                    for (uint16_t addr : { 0, 1, 2, 3, 4, 5, 6, 7, 16 }) {
+                        REQUIRE(fused.peek(addr) == plain.peek(addr));
+                    }
+                    for (uint16_t addr = 256; addr < 320; addr++) {
+                        REQUIRE(fused.peek(addr) == plain.peek(addr));
+                    }
+                    for (uint16_t addr = 3000; addr < 3005; addr++) {
+                        REQUIRE(fused.peek(addr) == plain.peek(addr));
+                    }
+                } while (steps == budget);
+            }
+        }
+
+        VMEmulator vm;
+        vm.setSuperinstructions(true);
+        vm.loadRawProgram(program);
+        vm.poke(0, 256);
+        vm.poke(1, 300);
+        vm.poke(2, 400);
+        vm.executeInstructions(10000);
+        REQUIRE(vm.peek(3000) == 0);
+        REQUIRE(vm.peek(3004) == 4);
+        REQUIRE(vm.peekStatic(0) == 5);
+        REQUIRE(vm.peekTemp(2) == 2);
+        REQUIRE(vm.peek(0) == 256);
+    }
+}
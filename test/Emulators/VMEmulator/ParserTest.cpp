@@ -0,0 +1,153 @@
+#include <catch2/catch_test_macros.hpp>
+#include "Emulators/VMEmulator/VMEmulator.hpp"
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const std::string STATICS_TEST = "../test/Emulators/VMEmulator/integration/TestCases/Project8/Function Calls/StaticsTest";
+}
+
+TEST_CASE("VM Parser: Each file has its own statics", "[bytecode]") {
+    VMParser parser;
+    SymbolTable table;
+    parser.loadLines("First", { "push static 0", "pop static 2" }, table);
+    parser.loadLines("Second", { "push constant 1", "pop static 1" }, table);
+    parser.loadLines("Third", { "push static 0" }, table);
+
+    const std::vector<VMInstruction>& code = parser.getBytecode();
+    REQUIRE(code[0].value == 0);
+    REQUIRE(code[1].value == 2);
+    REQUIRE(code[3].value == 4);
+    REQUIRE(code[4].value == 5);
+    REQUIRE(table.getStaticBase("Second") == 3);
+    REQUIRE(table.getStaticBase("Third") == 5);
+    REQUIRE_THROWS(table.getStaticBase("Fourth"));
+}
+
+TEST_CASE("VM Loader: Statics of a directory", "[loader]") {
+    VMEmulator vm;
+    vm.loadProgram(STATICS_TEST);
+
+    // Class1 and Class2 both use static 0 and 1
+    std::set<uint16_t> addresses = {
+        vm.getStaticAddress("Class1", 0), vm.getStaticAddress("Class1", 1),
+        vm.getStaticAddress("Class2", 0), vm.getStaticAddress("Class2", 1)
+    };
+    REQUIRE(addresses.size() == 4);
+    REQUIRE(*addresses.begin() == 16);
+    REQUIRE(*addresses.rbegin() == 19);
+
+    vm.executeInstructions(1000);
+    REQUIRE(vm.peek(vm.getStaticAddress("Class1", 0)) == 6);
+    REQUIRE(vm.peek(vm.getStaticAddress("Class1", 1)) == 8);
+    REQUIRE(vm.peek(vm.getStaticAddress("Class2", 0)) == 23);
+    REQUIRE(vm.peek(vm.getStaticAddress("Class2", 1)) == 15);
+}
+
+TEST_CASE("VM Loader: Programs with Sys.init start there", "[loader]") {
+    SECTION("The bootstrap frame of call Sys.init 0") {
+        VMEmulator vm;
+        vm.poke(1, 300);
+        vm.poke(2, 400);
+        vm.poke(3, 3000);
+        vm.poke(4, 3010);
+        vm.loadProgram(STATICS_TEST);
+
+        REQUIRE(vm.peek(0) == 261);
+        REQUIRE(vm.peek(1) == 261);
+        REQUIRE(vm.peek(2) == 256);
+        // Returning from Sys.init runs off the end of the program
+        REQUIRE(vm.peek(256) == static_cast<int16_t>(vm.getBytecode().size()));
+        REQUIRE(vm.peek(257) == 300);
+        REQUIRE(vm.peek(258) == 400);
+        REQUIRE(vm.peek(259) == 3000);
+        REQUIRE(vm.peek(260) == 3010);
+    }
+
+    SECTION("Sys.init runs first, with its locals zeroed") {
+        fs::path file = fs::temp_directory_path() / "vm_bootstrap_test" / "Sys.vm";
+        fs::create_directories(file.parent_path());
+        std::ofstream(file) << "function Sys.helper 0\npush constant 1\nreturn\n"
+                               "function Sys.init 2\npush constant 7\npop static 0\nlabel END\ngoto END\n";
+
+        VMEmulator vm;
+        vm.poke(261, 77);
+        vm.poke(262, 78);
+        vm.loadProgram(file.string());
+        REQUIRE(vm.peek(0) == 263);
+        REQUIRE(vm.peek(261) == 0);
+        REQUIRE(vm.peek(262) == 0);
+
+        vm.executeInstructions(2);
+        REQUIRE(vm.peek(vm.getStaticAddress("Sys", 0)) == 7);
+        REQUIRE(vm.peek(0) == 263);
+        fs::remove_all(file.parent_path());
+    }
+
+    SECTION("Other programs start at their first command") {
+        VMEmulator vm;
+        vm.poke(0, 300);
+        vm.loadProgram("../test/Emulators/VMEmulator/integration/TestCases/Project7/MemoryAccess/StaticTest/StaticTest.vm");
+        REQUIRE(vm.peek(0) == 300);
+
+        // push constant 111
+        vm.executeInstructions(1);
+        REQUIRE(vm.peek(0) == 301);
+        REQUIRE(vm.peek(300) == 111);
+    }
+}
+
+TEST_CASE("VM Parser: Directories load in filename order", "[bytecode]") {
+    fs::path dir = fs::temp_directory_path() / "vm_load_order_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::ofstream(dir / "Zed.vm") << "function Zed.g 0 // last\r\n  push static 2\r\nlabel LOOP\r\ngoto LOOP\r\n";
+    std::ofstream(dir / "Main.vm") << "function Main.main 1\npush static 0\ncall Alpha.f 1\nlabel LOOP\ngoto LOOP\n";
+    std::ofstream(dir / "Alpha.vm") << "function Alpha.f 0\nlabel LOOP\npush static 1\nif-goto LOOP\nreturn";
+    std::ofstream(dir / "notes.txt") << "not a VM file";
+
+    // One file after another gives the same program as the parallel load
+    VMParser serial;
+    SymbolTable serialTable;
+    for (const char* name : { "Alpha.vm", "Main.vm", "Zed.vm" }) {
+        serial.loadFile((dir / name).string(), serialTable);
+    }
+    serial.link(serialTable);
+
+    for (size_t threads : { 1, 2, 8 }) {
+        VMParser parser;
+        SymbolTable table;
+        parser.loadDirectory(dir.string(), table, threads);
+        parser.link(table);
+        const std::vector<VMInstruction>& code = parser.getBytecode();
+
+        REQUIRE(code.size() == 8);
+        REQUIRE(table.getFunctionAddress("Alpha.f").address == 0);
+        REQUIRE(table.getFunctionAddress("Main.main").address == 3);
+        REQUIRE(table.getFunctionAddress("Zed.g").address == 6);
+        REQUIRE(table.getStaticBase("Main") == 2);
+        REQUIRE(table.getStaticBase("Zed") == 3);
+        REQUIRE(code[1].target == 0);
+        REQUIRE(code[3].value == 2);
+        REQUIRE(code[4].target == 0);
+        REQUIRE(code[5].target == 5);
+        REQUIRE(code[6].value == 5);
+        REQUIRE(code[7].target == 7);
+
+        REQUIRE(parser.getSymbols() == serial.getSymbols());
+        for (size_t pc = 0; pc < code.size(); pc++) {
+            REQUIRE(code[pc].opcode == serial.getBytecode()[pc].opcode);
+            REQUIRE(code[pc].value == serial.getBytecode()[pc].value);
+            REQUIRE(code[pc].target == serial.getBytecode()[pc].target);
+        }
+    }
+
+    std::ofstream(dir / "Broken.vm") << "push constant 1\npush nowhere 2\n";
+    VMParser parser;
+    SymbolTable table;
+    REQUIRE_THROWS_WITH(parser.loadDirectory(dir.string(), table, 4), "Unknown segment: nowhere");
+    fs::remove_all(dir);
+}
@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include "Emulators/VMEmulator/VMEmulator.hpp"
+#include "Emulators/VMEmulator/CallGraphProfiler.hpp"
+
+namespace {
+    // Main.main runs 6 commands and calls Main.twice, 4 commands, twice;
+    // the top level runs its call, then loops forever
+    const std::vector<std::string> PROGRAM = {
+        "call Main.main 0",
+        "label END", "goto END",
+        "function Main.main 0",
+        "push constant 2", "call Main.twice 1",
+        "push constant 3", "call Main.twice 1",
+        "add", "return",
+        "function Main.twice 0",
+        "push argument 0", "push argument 0", "add", "return"
+    };
+
+    CallGraphProfiler::FunctionStats statsOf(const CallGraphProfiler& profiler, const VMEmulator& vm,
+                                             const std::string& name) {
+        for (const CallGraphProfiler::FunctionStats& stats : profiler.getFunctions(vm)) {
+            if (stats.name == name) {
+                return stats;
+            }
+        }
+        FAIL("No profile for " << name);
+        return {};
+    }
+
+    bool bothDispatches(VMDispatch dispatch) {
+        return dispatch == VMDispatch::SWITCH || VMEmulator::THREADED_DISPATCH_SUPPORTED;
+    }
+}
+
+TEST_CASE("VM Profiler: Calls and instruction counts per function", "[profiler]") {
+    for (VMDispatch dispatch : { VMDispatch::SWITCH, VMDispatch::THREADED }) {
+        if (!bothDispatches(dispatch)) {
+            continue;
+        }
+        VMEmulator vm;
+        vm.setDispatch(dispatch);
+        vm.loadRawProgram(PROGRAM);
+        vm.poke(1, 300);
+        vm.poke(2, 400);
+
+        CallGraphProfiler profiler;
+        // Budgets ending mid-function carry over to the next run
+        uint64_t steps = 0;
+        for (uint64_t budget : { 3, 4, 13 }) {
+            steps += vm.executeInstructions(budget, profiler);
+        }
+        REQUIRE(steps == 20);
+        REQUIRE(profiler.getTotalInstructions() == 20);
+
+        CallGraphProfiler::FunctionStats top = statsOf(profiler, vm, "(top)");
+        CallGraphProfiler::FunctionStats main = statsOf(profiler, vm, "Main.main");
+        CallGraphProfiler::FunctionStats twice = statsOf(profiler, vm, "Main.twice");
+        REQUIRE(top.calls == 0);
+        REQUIRE(top.exclusive == 6);
+        REQUIRE(top.inclusive == 20);
+        REQUIRE(main.calls == 1);
+        REQUIRE(main.exclusive == 6);
+        REQUIRE(main.inclusive == 14);
+        REQUIRE(twice.calls == 2);
+        REQUIRE(twice.exclusive == 8);
+        REQUIRE(twice.inclusive == 8);
+        REQUIRE(profiler.getFunctions(vm).front().name == "Main.twice");
+
+        std::ostringstream folded;
+        profiler.writeFolded(folded, vm);
+        REQUIRE(folded.str() == "(top) 6\n(top);Main.main 6\n(top);Main.main;Main.twice 8\n");
+    }
+}
+
+TEST_CASE("VM Profiler: Recursion and intrinsics", "[profiler]") {
+    SECTION("Recursive frames count once toward inclusive") {
+        VMEmulator vm;
+        vm.loadRawProgram({
+            "push constant 3", "call Main.down 1",
+            "label END", "goto END",
+            "function Main.down 0",
+            "push argument 0", "if-goto MORE",
+            "push constant 0", "return",
+            "label MORE",
+            "push argument 0", "push constant 1", "sub", "call Main.down 1", "return"
+        });
+        vm.poke(1, 300);
+        vm.poke(2, 400);
+
+        CallGraphProfiler profiler;
+        vm.executeInstructions(2 + 3 * 7 + 4, profiler);
+        CallGraphProfiler::FunctionStats down = statsOf(profiler, vm, "Main.down");
+        REQUIRE(down.calls == 4);
+        REQUIRE(down.exclusive == 25);
+        REQUIRE(down.inclusive == 25);
+
+        std::ostringstream folded;
+        profiler.writeFolded(folded, vm);
+        REQUIRE(folded.str().find("(top);Main.down;Main.down;Main.down;Main.down 4\n") != std::string::npos);
+    }
+
+    SECTION("Calls answered by an intrinsic run no commands") {
+        VMEmulator vm;
+        vm.registerIntrinsic("Main.twice", [](VMEmulator&, int16_t*, const int16_t* args, int16_t& result) {
+            result = static_cast<int16_t>(args[0] * 2);
+            return true;
+        });
+        vm.setIntrinsic("Main.twice", true);
+        vm.loadRawProgram(PROGRAM);
+        vm.poke(1, 300);
+        vm.poke(2, 400);
+
+        CallGraphProfiler profiler;
+        vm.executeInstructions(7, profiler);
+        REQUIRE(vm.peek(vm.peek(0) - 1) == 10);
+        REQUIRE(statsOf(profiler, vm, "Main.twice").calls == 2);
+        REQUIRE(statsOf(profiler, vm, "Main.twice").exclusive == 0);
+        REQUIRE(statsOf(profiler, vm, "Main.main").exclusive == 6);
+    }
+}
@@ -0,0 +1,65 @@
+#include <catch2/catch_test_macros.hpp>
+#include "Emulators/VMEmulator/VMEmulator.hpp"
+
+TEST_CASE("VM Run: Stop reasons and stack depth", "[bytecode][run]") {
+    SECTION("Running past the last command") {
+        VMEmulator vm;
+        vm.loadRawProgram({ "push constant 1", "push constant 2", "push constant 3", "add", "add" });
+        VMRunResult result = vm.run(1000);
+        REQUIRE(result.reason == VMStopReason::END_OF_PROGRAM);
+        REQUIRE(result.steps == 5);
+        REQUIRE(result.pc == 5);
+        REQUIRE(result.peakStackDepth == 3);
+        REQUIRE(vm.peekStack() == 6);
+    }
+
+    SECTION("Step budget, then halting in Sys.halt") {
+        VMEmulator vm;
+        vm.loadRawProgram({
+            "push constant 7", "call Main.deep 1",
+            "function Main.deep 2",
+            "push argument 0", "if-goto MORE",
+            "call Sys.halt 0",
+            "label MORE",
+            "push argument 0", "push constant 1", "sub", "call Main.deep 1",
+            "function Sys.halt 0",
+            "label LOOP", "goto LOOP"
+        });
+        vm.poke(1, 300);
+        vm.poke(2, 400);
+
+        VMRunResult first = vm.run(10);
+        REQUIRE(first.reason == VMStopReason::STEP_LIMIT);
+        REQUIRE(first.steps == 10);
+
+        VMRunResult second = vm.run(1000);
+        REQUIRE(second.reason == VMStopReason::HALTED);
+        REQUIRE(first.steps + second.steps == 2 + 7 * 6 + 3);
+        // Eight frames of an argument, five words and two locals, then Sys.halt's frame
+        REQUIRE(second.peakStackDepth == 8 * 8 + 5);
+
+        REQUIRE(vm.run(1000).reason == VMStopReason::HALTED);
+        REQUIRE(vm.run(1000).steps == 0);
+    }
+
+    SECTION("Errors") {
+        VMEmulator vm;
+        vm.loadRawProgram({
+            "call Main.forever 0",
+            "function Main.forever 0",
+            "call Main.forever 0"
+        });
+        VMRunResult overflow = vm.run(100000);
+        REQUIRE(overflow.reason == VMStopReason::ERROR);
+        REQUIRE(overflow.error == "Stack overflow calling Main.forever");
+        REQUIRE(vm.peek(0) > 2048);
+
+        vm.loadRawProgram({ "push constant 1", "return" });
+        vm.poke(0, 300);
+        vm.poke(1, 290);
+        vm.poke(285, 999);
+        VMRunResult badReturn = vm.run(100);
+        REQUIRE(badReturn.reason == VMStopReason::ERROR);
+        REQUIRE(badReturn.error == "Return to address 999 outside the program");
+    }
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch_test_macros.hpp>
+#include "Emulators/VMEmulator/VMEmulator.hpp"
+
+TEST_CASE("VM Stack Caching: Cached core matches the RAM stack", "[bytecode][caching]") {
+    // that 0 points into the live stack, so segment accesses hit the cached
+    // top and the word under it
+    const std::vector<std::string> aliasing = {
+        "push constant 11", "push constant 22", "push constant 257", "pop pointer 1",
+        "push constant 5", "add", "push that 0", "pop temp 0",
+        "push constant 1", "pop that 0", "add",
+        "push constant 0", "pop local 1", "push local 1", "pop local 0", "push temp 0",
+        "call Main.twice 1", "add",
+        "goto END",
+        "function Main.twice 1",
+        "push argument 0", "push argument 0", "add", "pop local 0", "push local 0", "return",
+        "label END"
+    };
+    const std::vector<std::string> loop = {
+        "push constant 0", "pop local 0",
+        "label LOOP",
+        "push local 0", "push constant 4", "lt", "not", "if-goto END",
+        "push constant 3000", "push local 0", "add", "push local 0", "neg",
+        "pop temp 0", "pop pointer 1", "push temp 0", "pop that 0",
+        "push constant 3000", "push local 0", "add", "pop pointer 1", "push that 0",
+        "push constant 0", "not", "and", "call Main.twice 1", "pop temp 1",
+        "push local 0", "push constant 1", "add", "pop local 0",
+        "goto LOOP",
+        "function Main.twice 1",
+        "push argument 0", "push argument 0", "add", "pop static 0", "push constant 0", "return",
+        "label END"
+    };
+
+    for (const std::vector<std::string>* program : { &aliasing, &loop }) {
+        for (VMDispatch dispatch : { VMDispatch::SWITCH, VMDispatch::THREADED }) {
+            for (bool fused : { false, true }) {
+                for (uint64_t budget : { 1, 2, 3, 7, 1000 }) {
+                    VMEmulator plain;
+                    VMEmulator cached;
+                    for (VMEmulator* vm : { &plain, &cached }) {
+                        vm->setDispatch(dispatch);
+                        vm->setSuperinstructions(fused);
+                        vm->loadRawProgram(*program);
+                        vm->poke(1, 300);
+                        vm->poke(2, 400);
+                    }
+                    cached.setStackCaching(true);
+
+                    uint64_t steps;
+                    do {
+                        steps = plain.executeInstructions(budget);
+                        REQUIRE(cached.executeInstructions(budget) == steps);
+                        REQUIRE(cached.getProgramCounter() == plain.getProgramCounter());
+                        for (uint16_t addr = 0; addr < plain.peek(0); addr++) {
+                            REQUIRE(cached.peek(addr) == plain.peek(addr));
+                        }
+                        for (uint16_t addr = 300; addr < 320; addr++) {
+                            REQUIRE(cached.peek(addr) == plain.peek(addr));
+                        }
+                        for (uint16_t addr = 3000; addr < 3005; addr++) {
+                            REQUIRE(cached.peek(addr) == plain.peek(addr));
+                        }
+                    } while (steps == budget);
+                }
+            }
+        }
+    }
+
+    VMEmulator vm;
+    vm.setStackCaching(true);
+    vm.loadRawProgram(aliasing);
+    vm.poke(1, 300);
+    vm.poke(2, 400);
+    REQUIRE(vm.run(1000).reason == VMStopReason::END_OF_PROGRAM);
+    REQUIRE(vm.peekTemp(0) == 27);
+    REQUIRE(vm.peek(0) == 257);
+    REQUIRE(vm.peekStack() == 12 + 54);
+}
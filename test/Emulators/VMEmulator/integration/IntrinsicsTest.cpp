@@ -0,0 +1,149 @@
+#include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <filesystem>
+
+#include "Emulators/VMEmulator/VMEmulator.hpp"
+#include "JackCompiler/CompilationEngine.hpp"
+
+namespace {
+    // Exercises every intrinsic, leaving results at RAM[8000..] and 1 in
+    // RAM[8011] when done
+    const char* const MAIN_JACK = R"(
+class Main {
+    function void main() {
+        var Array results, blocks;
+        var String s;
+        var int i;
+        let results = 8000;
+        let results[0] = 123 * 45;
+        let results[1] = -300 * 7;
+        let results[2] = 32767 * 3;
+        let results[3] = 1000 / 7;
+        let results[4] = -1000 / 7;
+        let results[5] = 1000 / -33;
+        let results[6] = -32767 / 2;
+        let blocks = Array.new(10);
+        let i = 0;
+        while (i < 10) {
+            let blocks[i] = Array.new(i + 1);
+            let i = i + 1;
+        }
+        do Memory.deAlloc(blocks[3]);
+        do Memory.deAlloc(blocks[5]);
+        let results[7] = Array.new(2);
+        let results[8] = Array.new(50);
+        let s = String.new(8);
+        do s.appendChar(72);
+        do s.appendChar(105);
+        let results[9] = s;
+        let results[10] = s.length();
+        do Screen.clearScreen();
+        do Screen.drawHorizontalLine(3, 9, 10);
+        do Screen.drawHorizontalLine(5, 200, 20);
+        do Screen.drawHorizontalLine(16, 47, 30);
+        do Screen.setColor(false);
+        do Screen.drawHorizontalLine(20, 100, 20);
+        do Screen.setColor(true);
+        do Screen.drawRectangle(10, 40, 60, 50);
+        let results[11] = 1;
+        return;
+    }
+}
+)";
+
+    // Compiles OSLib with MAIN_JACK once and returns the directory of .vm files
+    std::string compiledProgram() {
+        static std::string outputDir;
+        if (outputDir.empty()) {
+            fs::path root = fs::temp_directory_path() / "vm_intrinsics_test";
+            fs::path source = root / "Prog";
+            fs::remove_all(root);
+            fs::create_directories(source);
+            for (const auto& entry : fs::directory_iterator("../OSLib")) {
+                if (entry.path().extension() == ".jack") {
+                    fs::copy_file(entry.path(), source / entry.path().filename());
+                }
+            }
+            std::ofstream(source / "Main.jack") << MAIN_JACK;
+
+            CompilationEngine engine(source.string(), (root / "out").string());
+            engine.compile();
+            outputDir = (root / "out" / "Prog").string();
+        }
+        return outputDir;
+    }
+
+    uint64_t runToHalt(VMEmulator& vm) {
+        VMRunResult result = vm.run(100000000);
+        REQUIRE(result.reason == VMStopReason::HALTED);
+        REQUIRE(vm.peek(8011) == 1);
+        return result.steps;
+    }
+
+    // Everything but the unused stack above SP
+    void requireSameRam(const VMEmulator& actual, const VMEmulator& expected) {
+        for (uint16_t addr = 0; addr < 24576; addr++) {
+            if (addr >= expected.peek(VMEmulator::STACK_POINTER) && addr < 2048) {
+                continue;
+            }
+            REQUIRE(actual.peek(addr) == expected.peek(addr));
+        }
+    }
+}
+
+TEST_CASE("VM Intrinsics: Host OS functions match the interpreted OS", "[intrinsics]") {
+    std::string program = compiledProgram();
+
+    VMEmulator interpreted;
+    interpreted.loadProgram(program);
+    uint64_t interpretedSteps = runToHalt(interpreted);
+
+    REQUIRE(interpreted.peek(8000) == 5535);
+    REQUIRE(interpreted.peek(8001) == -2100);
+    REQUIRE(interpreted.peek(8002) == 32765);
+    REQUIRE(interpreted.peek(8003) == 142);
+    REQUIRE(interpreted.peek(8004) == -142);
+    REQUIRE(interpreted.peek(8005) == -30);
+    REQUIRE(interpreted.peek(8006) == -16383);
+    REQUIRE(interpreted.peek(8010) == 2);
+
+    SECTION("All at once") {
+        VMEmulator vm;
+        vm.setIntrinsics(true);
+        vm.loadProgram(program);
+        uint64_t steps = runToHalt(vm);
+
+        requireSameRam(vm, interpreted);
+        REQUIRE(steps < interpretedSteps / 2);
+    }
+
+    SECTION("With superinstructions and a cached stack") {
+        VMEmulator vm;
+        vm.setIntrinsics(true);
+        vm.setSuperinstructions(true);
+        vm.setStackCaching(true);
+        vm.loadProgram(program);
+        runToHalt(vm);
+
+        requireSameRam(vm, interpreted);
+    }
+
+    SECTION("One at a time") {
+        for (const std::string& name : interpreted.getIntrinsicNames()) {
+            VMEmulator vm;
+            vm.loadProgram(program);
+            vm.setIntrinsic(name, true);
+            REQUIRE(vm.isIntrinsicEnabled(name));
+            uint64_t steps = runToHalt(vm);
+
+            requireSameRam(vm, interpreted);
+            REQUIRE(steps < interpretedSteps);
+        }
+    }
+
+    SECTION("Registry") {
+        REQUIRE(interpreted.getIntrinsicNames().size() == 6);
+        REQUIRE_FALSE(interpreted.isIntrinsicEnabled("Math.multiply"));
+        REQUIRE_THROWS(interpreted.setIntrinsic("Math.sqrt", true));
+    }
+}
@@ -15,9 +15,8 @@ TEST_CASE("VM Emulator runs Project7/MemoryAccess/BasicTest Test Case", "[HackEm
     emu.poke(3, 3000);
     emu.poke(4, 3010);
 
-    for (int i = 0; i < 600; i++) {
-        emu.executeNextInstruction();
-    }
+    VMRunResult result = emu.run(600);
+    REQUIRE(result.reason == VMStopReason::END_OF_PROGRAM);
 
     REQUIRE(emu.peek(256) == 472);
     REQUIRE(emu.peek(300) == 10);
@@ -35,9 +34,8 @@ TEST_CASE("VM Emulator runs Project7/MemoryAccess/PointerTest Test Case", "[Hack
 
     emu.poke(0, 256);
 
-    for (int i = 0; i < 450; i++) {
-        emu.executeNextInstruction();
-    }
+    VMRunResult result = emu.run(450);
+    REQUIRE(result.reason == VMStopReason::END_OF_PROGRAM);
 
     REQUIRE(emu.peek(256) == 6084);
     REQUIRE(emu.peek(3) == 3030);
@@ -52,9 +50,8 @@ TEST_CASE("VM Emulator runs Project7/MemoryAccess/StaticTest Test Case", "[HackE
 
     emu.poke(0, 256);
 
-    for (int i = 0; i < 200; i++) {
-        emu.executeNextInstruction();
-    }
+    VMRunResult result = emu.run(200);
+    REQUIRE(result.reason == VMStopReason::END_OF_PROGRAM);
 
     REQUIRE(emu.peek(256) == 1110);
 }
@@ -65,9 +62,8 @@ TEST_CASE("VM Emulator runs Project7/StackArithmetic/SimpleAdd Test Case", "[Hac
 
     emu.poke(0, 256);
 
-    for (int i = 0; i < 600; i++) {
-        emu.executeNextInstruction();
-    }
+    VMRunResult result = emu.run(600);
+    REQUIRE(result.reason == VMStopReason::END_OF_PROGRAM);
 
     REQUIRE(emu.peek(0) == 257);
     REQUIRE(emu.peek(256) == 15);
@@ -79,9 +75,8 @@ TEST_CASE("VM Emulator runs Project7/StackArithmetic/StackTest Test Case", "[Hac
 
     emu.poke(0, 256);
 
-    for (int i = 0; i < 600; i++) {
-        emu.executeNextInstruction();
-    }
+    VMRunResult result = emu.run(600);
+    REQUIRE(result.reason == VMStopReason::END_OF_PROGRAM);
 
     REQUIRE(emu.peek(0) == 266);
     REQUIRE(emu.peek(256) == -1);
@@ -106,9 +101,8 @@ TEST_CASE("VM Emulator runs Project8/Program Flow/BasicLoop Test Case", "[HackEm
     emu.poke(2, 400);
     emu.poke(400, 3);
 
-    for (int i = 0; i < 600; i++) {
-        emu.executeNextInstruction();
-    }
+    VMRunResult result = emu.run(600);
+    REQUIRE(result.reason == VMStopReason::END_OF_PROGRAM);
 
     REQUIRE(emu.peek(0) == 257);
     REQUIRE(emu.peek(256) == 6);
@@ -124,9 +118,8 @@ TEST_CASE("VM Emulator runs Project8/Program Flow/FibonacciSeries Test Case", "[
     emu.poke(400, 6);
     emu.poke(401, 3000);
 
-    for (int i = 0; i < 1100; i++) {
-        emu.executeNextInstruction();
-    }
+    VMRunResult result = emu.run(1100);
+    REQUIRE(result.reason == VMStopReason::END_OF_PROGRAM);
 
     REQUIRE(emu.peek(3000) == 0);
     REQUIRE(emu.peek(3001) == 1);
@@ -135,3 +128,55 @@ TEST_CASE("VM Emulator runs Project8/Program Flow/FibonacciSeries Test Case", "[
     REQUIRE(emu.peek(3004) == 3);
     REQUIRE(emu.peek(3005) == 5);
 }
+
+TEST_CASE("VM Emulator runs Project8/Function Calls/NestedCall Test Case", "[HackEmulator][NestedCall]") {
+    VMEmulator emu;
+    emu.loadProgram("../test/Emulators/VMEmulator/integration/TestCases/Project8/Function Calls/NestedCall/Sys.vm");
+
+    emu.poke(3, 3000);
+    emu.poke(4, 4000);
+    emu.poke(5, -1);
+    emu.poke(6, -1);
+
+    VMRunResult result = emu.run(1000);
+    REQUIRE(result.reason == VMStopReason::HALTED);
+    REQUIRE(result.steps == 38);
+
+    REQUIRE(emu.peek(0) == 261);
+    REQUIRE(emu.peek(1) == 261);
+    REQUIRE(emu.peek(2) == 256);
+    REQUIRE(emu.peek(3) == 4000);
+    REQUIRE(emu.peek(4) == 5000);
+    REQUIRE(emu.peek(5) == 135);
+    REQUIRE(emu.peek(6) == 246);
+}
+
+TEST_CASE("VM Emulator runs Project8/Function Calls/FibonacciElement Test Case", "[HackEmulator][FibonacciElement]") {
+    VMEmulator emu;
+    emu.loadProgram("../test/Emulators/VMEmulator/integration/TestCases/Project8/Function Calls/FibonacciElement");
+
+    VMRunResult result = emu.run(1000);
+    REQUIRE(result.reason == VMStopReason::HALTED);
+    REQUIRE(result.steps == 93);
+
+    REQUIRE(emu.peek(0) == 262);
+    REQUIRE(emu.peek(261) == 3);
+}
+
+TEST_CASE("VM Emulator runs Project8/Function Calls/StaticsTest Test Case", "[HackEmulator][StaticsTest]") {
+    VMEmulator emu;
+    emu.loadProgram("../test/Emulators/VMEmulator/integration/TestCases/Project8/Function Calls/StaticsTest");
+
+    VMRunResult result = emu.run(1000);
+    REQUIRE(result.reason == VMStopReason::HALTED);
+    REQUIRE(result.steps == 31);
+
+    REQUIRE(emu.peek(0) == 263);
+    REQUIRE(emu.peek(261) == -2);
+    REQUIRE(emu.peek(262) == 8);
+
+    // Still at the END loop
+    result = emu.run(1000);
+    REQUIRE(result.reason == VMStopReason::HALTED);
+    REQUIRE(result.steps == 0);
+}
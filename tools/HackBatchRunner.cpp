@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Emulators/HackEmulator/BatchRunner.hpp"
+
+// Runs every nand2tetris CPU test script (.tst) found under the given paths
+// concurrently and reports the RAM checks from the matching .cmp files:
+//     ./HackEmulator_batch [--threads N] [--repeat K] [--block-cache] <dir|script.tst>...
+// --repeat queues each script K times, which is handy for measuring scaling.
+
+int main(int argc, char* argv[]) {
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t repeat = 1;
+    ExecutionMode mode = ExecutionMode::INTERPRETED;
+    std::vector<std::string> paths;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                threads = std::stoul(argv[++i]);
+            } else if (arg == "--repeat" && i + 1 < argc) {
+                repeat = std::stoul(argv[++i]);
+            } else if (arg == "--block-cache") {
+                mode = ExecutionMode::BLOCK_CACHE;
+            } else {
+                paths.push_back(arg);
+            }
+        }
+        if (paths.empty()) {
+            std::cerr << "Usage: " << argv[0] << " [--threads N] [--repeat K] [--block-cache] <dir|script.tst>..." << std::endl;
+            return 1;
+        }
+
+        std::vector<BatchJob> corpus;
+        for (const std::string& path : paths) {
+            if (std::filesystem::is_directory(path)) {
+                std::vector<BatchJob> found = BatchRunner::discoverTestScripts(path);
+                corpus.insert(corpus.end(), found.begin(), found.end());
+            } else {
+                corpus.push_back(BatchRunner::loadTestScript(path));
+            }
+        }
+        std::vector<BatchJob> jobs;
+        for (size_t r = 0; r < repeat; r++) {
+            jobs.insert(jobs.end(), corpus.begin(), corpus.end());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<BatchResult> results = BatchRunner(threads, mode).run(jobs);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t failed = 0;
+        uint64_t cycles = 0;
+        for (size_t i = 0; i < results.size(); i++) {
+            const BatchResult& result = results[i];
+            cycles += result.run.cycles;
+            if (!result.passed) {
+                failed++;
+            }
+            // Repeated copies only report failures
+            if (i >= corpus.size() && result.passed) {
+                continue;
+            }
+            std::cout << (result.passed ? "PASS " : "FAIL ") << std::left << std::setw(24) << result.name
+                      << std::right << std::setw(10) << result.run.cycles << " cycles"
+                      << (result.run.reason == StopReason::HALTED ? " (halted)" : "") << "\n";
+            for (const std::string& failure : result.failures) {
+                std::cout << "     " << failure << "\n";
+            }
+        }
+
+        std::cout << "\n" << (results.size() - failed) << "/" << results.size() << " passed on "
+                  << threads << " threads in " << std::fixed << std::setprecision(3) << seconds << "s ("
+                  << cycles << " cycles)" << std::endl;
+        return failed == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,35 @@
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Emulators/FileLoader.hpp"
+#include "Emulators/HackEmulator/NativeTranslator.hpp"
+
+// Translates a .hack or .bin ROM into a C++ source file defining one
+// NativeProgram function, to be built into a host program:
+//     ./HackEmulator_aot <program.hack> <out.cpp> <function>
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <program.hack> <out.cpp> <function>" << std::endl;
+        return 1;
+    }
+
+    try {
+        FileLoader loader;
+        NativeTranslator translator(loader.loadFile(argv[1]), argv[3]);
+
+        std::ofstream out(argv[2]);
+        if (!out.is_open()) {
+            std::cerr << "Error: could not open " << argv[2] << std::endl;
+            return 1;
+        }
+        translator.write(out);
+        std::cout << "Wrote " << translator.getBlockCount() << " blocks to " << argv[2] << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
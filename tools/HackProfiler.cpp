@@ -0,0 +1,42 @@
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Emulators/FileLoader.hpp"
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/ExecutionProfiler.hpp"
+
+// Runs a .hack program under the execution profiler and prints a report joined
+// with the assembler listing (assemble with listings enabled to get one):
+//     ./HackEmulator_profile <program.hack> <program.listing.txt> [cycles] [top]
+// The program starts with SP = 256 and runs until it halts or spends the budget.
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <program.hack> <program.listing.txt> [cycles] [top]" << std::endl;
+        return 1;
+    }
+
+    try {
+        uint64_t cycles = argc > 3 ? std::stoull(argv[3]) : 10000000;
+        size_t top = argc > 4 ? std::stoul(argv[4]) : 20;
+
+        FileLoader loader;
+        HackEmulator emu;
+        emu.loadProgram(loader.loadFile(argv[1]));
+        emu.setRamValue(HackEmulator::STACK_POINTER, 256);
+
+        ExecutionProfiler profiler;
+        RunResult result = emu.run(cycles, profiler);
+        std::cout << "Stopped at PC " << result.pc << " after " << result.cycles << " cycles"
+                  << (result.reason == StopReason::HALTED ? " (halted)" : "") << "\n\n";
+
+        profiler.writeReport(std::cout, argv[2], top);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
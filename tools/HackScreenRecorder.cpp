@@ -0,0 +1,58 @@
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "Emulators/FileLoader.hpp"
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/KeyboardInput.hpp"
+#include "Emulators/HackEmulator/ScreenRecorder.hpp"
+
+// Runs a .hack program and writes a screen frame every cyclesPerFrame cycles:
+//     ./HackEmulator_record <program.hack> <outputDir> [pbm|ppm|raw] [cyclesPerFrame] [maxCycles] [keys.txt]
+// Frames are numbered image files; e.g. ffmpeg -i frame_%06d.pbm turns them into a video.
+// A keyboard recording (see KeyboardInput) is replayed into KBD during the run.
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <program.hack> <outputDir> [pbm|ppm|raw] [cyclesPerFrame] [maxCycles] [keys.txt]"
+                  << std::endl;
+        return 1;
+    }
+
+    try {
+        std::string formatName = argc > 3 ? argv[3] : "pbm";
+        uint64_t cyclesPerFrame = argc > 4 ? std::stoull(argv[4]) : 1000000;
+        uint64_t maxCycles = argc > 5 ? std::stoull(argv[5]) : 100000000;
+
+        FrameFormat format;
+        if (formatName == "pbm") {
+            format = FrameFormat::PBM;
+        } else if (formatName == "ppm") {
+            format = FrameFormat::PPM;
+        } else if (formatName == "raw") {
+            format = FrameFormat::RAW;
+        } else {
+            throw std::invalid_argument("Unknown frame format: " + formatName);
+        }
+
+        FileLoader loader;
+        HackEmulator emu;
+        emu.setMemoryMode(MemoryMode::FAST);
+        emu.loadProgram(loader.loadFile(argv[1]));
+        KeyboardInput keys;
+        if (argc > 6) {
+            keys = KeyboardInput::load(argv[6]);
+            emu.setKeyboardInput(&keys);
+        }
+
+        ScreenRecorder recorder(argv[2], format, cyclesPerFrame);
+        RunResult result = recorder.run(emu, maxCycles);
+        std::cout << "Wrote " << recorder.getFrameCount() << " frames over " << result.cycles << " cycles"
+                  << (result.reason == StopReason::HALTED ? " (halted)" : "") << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Emulators/FileLoader.hpp"
+#include "Emulators/HackEmulator/HackEmulator.hpp"
+#include "Emulators/HackEmulator/ExecutionTracer.hpp"
+
+// Runs a .hack program with every instruction traced to a binary file, then
+// prints the last records of the trace:
+//     ./HackEmulator_trace <program.hack> <out.trace> [cycles] [tail]
+// The program starts with SP = 256 and runs until it halts or spends the budget.
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <program.hack> <out.trace> [cycles] [tail]" << std::endl;
+        return 1;
+    }
+
+    try {
+        uint64_t cycles = argc > 3 ? std::stoull(argv[3]) : 10000000;
+        size_t tail = argc > 4 ? std::stoul(argv[4]) : 20;
+
+        FileLoader loader;
+        HackEmulator emu;
+        emu.loadProgram(loader.loadFile(argv[1]));
+        emu.setRamValue(HackEmulator::STACK_POINTER, 256);
+
+        ExecutionTracer tracer(1 << 16, TraceOverflow::WAIT);
+        TraceWriter writer(tracer, argv[2]);
+        RunResult result = emu.run(cycles, tracer);
+        writer.finish();
+
+        std::cout << "Stopped at PC " << result.pc << " after " << result.cycles << " cycles"
+                  << (result.reason == StopReason::HALTED ? " (halted)" : "") << ", "
+                  << writer.getRecordCount() << " records written to " << argv[2] << "\n\n";
+
+        std::vector<TraceRecord> records = TraceWriter::readTrace(argv[2]);
+        size_t first = records.size() - std::min(tail, records.size());
+        std::cout << std::setw(8) << "PC" << std::setw(8) << "A" << std::setw(8) << "D" << "   M write\n";
+        for (size_t i = first; i < records.size(); i++) {
+            const TraceRecord& record = records[i];
+            std::cout << std::setw(8) << record.pc << std::setw(8) << record.a_register << std::setw(8) << record.d_register;
+            if (record.flags & ExecutionTracer::WROTE_M) {
+                std::cout << "   RAM[" << record.m_address << "] = " << record.m_value;
+            }
+            std::cout << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
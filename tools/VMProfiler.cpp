@@ -0,0 +1,46 @@
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Emulators/VMEmulator/VMEmulator.hpp"
+#include "Emulators/VMEmulator/CallGraphProfiler.hpp"
+
+// Runs a VM program under the call-graph profiler, prints the functions with
+// the most commands and optionally writes folded stacks for flamegraph.pl:
+//     ./VMEmulator_profile <program.vm|dir> [steps] [stacks.folded] [top]
+// A directory with Sys.init starts there; anything else starts at its first
+// command with SP = 256.
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <program.vm|dir> [steps] [stacks.folded] [top]" << std::endl;
+        return 1;
+    }
+
+    try {
+        uint64_t steps = argc > 2 ? std::stoull(argv[2]) : 10000000;
+        size_t top = argc > 4 ? std::stoul(argv[4]) : 20;
+
+        VMEmulator vm;
+        vm.loadProgram(argv[1]);
+
+        CallGraphProfiler profiler;
+        uint64_t executed = vm.executeInstructions(steps, profiler);
+        std::cout << "Stopped at PC " << vm.getProgramCounter() << " after " << executed << " commands\n\n";
+        profiler.writeReport(std::cout, vm, top);
+
+        if (argc > 3) {
+            std::ofstream folded(argv[3]);
+            if (!folded) {
+                throw std::runtime_error("Cannot write " + std::string(argv[3]));
+            }
+            profiler.writeFolded(folded, vm);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}